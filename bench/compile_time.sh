@@ -0,0 +1,71 @@
+#!/bin/sh
+# compile_time.sh -- Compares the compile time of a translation unit that
+# uses split() and join() when it includes split.h (with and without the
+# regex overloads, and in compiled mode) against one that imports module
+# org.ppires.split.  If BASELINE names a directory holding an older split.h
+# (e.g. from "git show 8740298:split.h"), including it is timed as well.
+#
+# Usage: bench/compile_time.sh [runs]
+# Environment: CXX (default c++), CXXFLAGS (default -O2), BASELINE.
+# Module import needs GCC 14 or later, or Clang 16 or later.
+
+set -e
+
+runs=${1:-5}
+CXX=${CXX:-c++}
+CXXFLAGS=${CXXFLAGS:--O2}
+src=$(cd "$(dirname "$0")/.." && pwd)
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+cd "$work"
+
+body='
+std::string f(const std::string &s){
+	auto v=org::ppires::split(s, ",");
+	return org::ppires::join(v, std::string("|"));
+}
+int main(){ return f("a,b").size()!=3; }'
+
+printf '#include "split.h"\n%s\n' "$body" >include.cpp
+printf '#define ORG_PPIRES_SPLIT_NO_REGEX\n#include "split.h"\n%s\n' "$body" >include_no_regex.cpp
+printf '#include <string>\nimport org.ppires.split;\n%s\n' "$body" >import.cpp
+
+case $($CXX --version | head -n 1) in
+	*clang*)
+		module_build="$CXX -std=c++20 $CXXFLAGS -I$src --precompile -o org.ppires.split.pcm $src/split.cppm"
+		module_flags="-fprebuilt-module-path=."
+		;;
+	*)
+		module_build="$CXX -std=c++20 $CXXFLAGS -I$src -fmodules-ts -x c++ -c -o split_module.o $src/split.cppm"
+		module_flags="-fmodules-ts"
+		;;
+esac
+
+# Prints the average wall time, in milliseconds, of compiling $1 $runs times,
+# with extra flags $2 and include path $3 (default: this tree).
+time_compile(){
+	start=$(date +%s%N)
+	i=0
+	while [ $i -lt "$runs" ]; do
+		$CXX -std=c++20 $CXXFLAGS -I"${3:-$src}" $2 -c "$1" -o out.o
+		i=$((i+1))
+	done
+	end=$(date +%s%N)
+	echo $(( (end-start)/runs/1000000 ))
+}
+
+if [ -n "$BASELINE" ]; then
+	echo "include baseline split.h:            $(time_compile include.cpp "" "$BASELINE") ms"
+fi
+echo "include split.h:                     $(time_compile include.cpp) ms"
+echo "include split.h, no regex overloads: $(time_compile include_no_regex.cpp) ms"
+echo "include split.h, compiled mode:      $(time_compile include.cpp -DORG_PPIRES_SPLIT_COMPILED) ms"
+if
+	$module_build 2>module.log &&
+	$CXX -std=c++20 $CXXFLAGS $module_flags -c import.cpp -o out.o 2>>module.log
+then
+	echo "import org.ppires.split:             $(time_compile import.cpp "$module_flags") ms"
+else
+	echo "import org.ppires.split:             skipped, $CXX failed to build or import the module:"
+	grep -m 5 -e 'error' -e 'internal compiler error' module.log | sed 's/^/    /'
+fi
@@ -0,0 +1,77 @@
+// join_small.cpp -- Compares join() of many short strings, which copies
+// them with fixed-width moves, against the stream insertion basic_join()
+// used for them before, and against appending each one to a reserved
+// std::string.
+//
+// Build: c++ -std=c++17 -O2 -I.. join_small.cpp -o join_small
+// Usage: ./join_small [elements]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#define ORG_PPIRES_SPLIT_NO_REGEX
+#include "split.h"
+
+// The stream path that basic_join() takes for elements other than strings.
+static std::string stream_join(const std::vector<std::string> &v, const char *joiner){
+	std::ostringstream output;
+	auto first=v.begin(), last=v.end();
+	if(first!=last){
+		output << *first;
+		while(++first!=last)
+			output << joiner << *first;
+	}
+	return output.str();
+}
+
+static std::string append_join(const std::vector<std::string> &v, const char *joiner){
+	const std::string_view j(joiner);
+	size_t total=0;
+	for(auto &s: v)
+		total+=s.size()+j.size();
+	std::string result;
+	result.reserve(total);
+	for(size_t i=0; i<v.size(); ++i){
+		if(i)
+			result.append(j);
+		result.append(v[i]);
+	}
+	return result;
+}
+
+template<class fn_t>
+static double ns_per_element(size_t n, fn_t &&fn){
+	double best=1e300;
+	for(int r=0; r<5; ++r){
+		auto t0=std::chrono::steady_clock::now();
+		fn();
+		auto t1=std::chrono::steady_clock::now();
+		best=std::min(best, std::chrono::duration<double, std::nano>(t1-t0).count()/n);
+	}
+	return best;
+}
+
+int main(int argc, char **argv){
+	const size_t n=argc>1? std::strtoul(argv[1], nullptr, 10): 1000000;
+	size_t sink=0;
+	std::printf("%5s %12s %12s %12s   (ns per element)\n", "bytes", "stream", "append", "join()");
+	for(size_t len: {1, 2, 3, 4, 6, 8, 12, 16, 24, 32, 48, 64}){
+		// Lengths vary between len/2 and len, as real fields do.
+		std::vector<std::string> v(n);
+		for(size_t i=0; i<n; ++i)
+			v[i].assign(len-(i*7)%(len/2+1), char('a'+i%26));
+		const double t_stream=ns_per_element(n, [&]{ sink+=stream_join(v, ",").size(); });
+		const double t_append=ns_per_element(n, [&]{ sink+=append_join(v, ",").size(); });
+		const double t_join=ns_per_element(n, [&]{ sink+=org::ppires::join(v, ",").size(); });
+		if(org::ppires::join(v, ",")!=stream_join(v, ",")){
+			std::fprintf(stderr, "join() differs from the stream result for length %zu\n", len);
+			return 1;
+		}
+		std::printf("%5zu %12.2f %12.2f %12.2f\n", len, t_stream, t_append, t_join);
+	}
+	return sink==0;
+}
@@ -0,0 +1,87 @@
+// profile_fields.cpp -- Compares profile_fields() against splitting every
+// record into strings and computing the same statistics afterwards.
+//
+// Build: c++ -std=c++17 -O2 -pthread -I.. profile_fields.cpp -o profile_fields
+// Usage: ./profile_fields [records] [threads]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#define ORG_PPIRES_SPLIT_NO_REGEX
+#include "split.h"
+#include "split_parallel.h"
+
+using namespace org::ppires;
+
+static std::string make_corpus(size_t n_records){
+	std::string buf;
+	buf.reserve(n_records*48);
+	for(size_t i=0; i<n_records; ++i){
+		buf+=std::to_string(i);
+		buf+=",user";
+		buf+=std::to_string(i*7919%20000);
+		buf+=",";
+		buf+=std::to_string(i%97*1.25);
+		buf+=",";
+		buf.append(i%13, 'x');
+		buf+=i%5? ",ok\n": ",error\n";
+	}
+	return buf;
+}
+
+template<class fn_t>
+static double time_ms(fn_t &&fn, int runs=5){
+	double best=1e300;
+	for(int r=0; r<runs; ++r){
+		auto t0=std::chrono::steady_clock::now();
+		fn();
+		auto t1=std::chrono::steady_clock::now();
+		best=std::min(best, std::chrono::duration<double, std::milli>(t1-t0).count());
+	}
+	return best;
+}
+
+int main(int argc, char **argv){
+	const size_t n_records=argc>1? std::strtoul(argv[1], nullptr, 10): 2000000;
+	const size_t n_threads=argc>2? std::strtoul(argv[2], nullptr, 10): 0;
+	const std::string corpus=make_corpus(n_records);
+
+	size_t sink=0;
+	const double baseline=time_ms(
+		[&]{
+			// Exact distinct counts, as a post-processing pass would get them.
+			std::vector<std::unordered_set<std::string>> distinct;
+			std::vector<size_t> fields_per_record;
+			for(auto &rec: split(std::string_view(corpus), '\n')){
+				auto fields=split(std::string_view(rec), ',');
+				if(fields.size()>=fields_per_record.size())
+					fields_per_record.resize(fields.size()+1);
+				++fields_per_record[fields.size()];
+				if(distinct.size()<fields.size())
+					distinct.resize(fields.size());
+				for(size_t i=0; i<fields.size(); ++i)
+					distinct[i].insert(std::move(fields[i]));
+			}
+			sink+=distinct[1].size();
+		},
+		1
+	);
+	const double one=time_ms([&]{ sink+=profile_fields(corpus, '\n', ',', 1).records; });
+	const double many=time_ms([&]{ sink+=profile_fields(corpus, '\n', ',', n_threads).records; });
+
+	const auto prof=profile_fields(corpus, '\n', ',', n_threads);
+	std::printf("%zu records, %.1f MB, %.3f separators/byte\n", prof.records, corpus.size()/1e6, prof.separator_density());
+	for(size_t i=0; i<prof.columns.size(); ++i)
+		std::printf(
+			"  column %zu: mean length %.2f, max %zu, ~%.0f distinct\n",
+			i, prof.columns[i].mean_length(), prof.columns[i].max_length, prof.columns[i].distinct.estimate()
+		);
+	std::printf("split + post-processing: %9.1f ms\n", baseline);
+	std::printf("profile_fields, 1 thread: %8.1f ms\n", one);
+	std::printf("profile_fields, %s threads: %5.1f ms\n", n_threads? std::to_string(n_threads).c_str(): "all", many);
+	return sink==0;
+}
@@ -0,0 +1,76 @@
+#!/bin/sh
+# splitcut.sh -- Compares examples/splitcut against cut and awk, selecting
+# fields 2, 5 and 9 of a synthetic tab-separated corpus and writing them
+# comma-separated.  The outputs are checked to be identical, so this also
+# serves as an end-to-end test of split.h.
+#
+# Usage: bench/splitcut.sh [records] [runs]
+# Environment: CXX (default c++), CXXFLAGS (default -O2).
+
+set -e
+
+records=${1:-2000000}
+runs=${2:-3}
+CXX=${CXX:-c++}
+CXXFLAGS=${CXXFLAGS:--O2}
+src=$(cd "$(dirname "$0")/.." && pwd)
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+cd "$work"
+
+$CXX -std=c++17 $CXXFLAGS -pthread -I"$src" "$src/examples/splitcut.cpp" -o splitcut
+
+# Ten columns of mixed width: ids, words, numbers and a timestamp.
+awk -v n="$records" 'BEGIN {
+	OFS="\t"
+	for(i=0; i<n; i++)
+		print i, "user" i%5000, i*31%100000/7, "host-" i%97, "GET", i%13, \
+			"2026-10-" 10+i%20 "T12:" 10+i%50 ":00Z", "/path/to/item/" i%1000, i%2 ? "ok" : "error", \
+			"payload-" i
+}' >corpus.tsv
+size=$(wc -c <corpus.tsv)
+
+# Prints the best wall time, in milliseconds, of running "$@" $runs times
+# with output to $out.
+best_ms(){
+	best=
+	i=0
+	while [ $i -lt "$runs" ]; do
+		start=$(date +%s%N)
+		"$@" >"$out"
+		end=$(date +%s%N)
+		t=$(( (end-start)/1000000 ))
+		if [ -z "$best" ] || [ $t -lt $best ]; then
+			best=$t
+		fi
+		i=$((i+1))
+	done
+	echo $best
+}
+
+report(){
+	awk -v name="$1" -v ms="$2" -v bytes="$size" 'BEGIN {
+		printf "%-28s %8d ms %10.1f MB/s\n", name, ms, ms? bytes/1e3/ms: 0
+	}'
+}
+
+printf '%d records, %.1f MB\n' "$records" "$(awk -v b="$size" 'BEGIN { print b/1e6 }')"
+
+out=cut.out
+report "cut -f2,5,9" "$(best_ms cut -f2,5,9 --output-delimiter=, corpus.tsv)"
+out=awk.out
+report "awk -F tab" "$(best_ms awk -F'\t' -v OFS=, '{ print $2, $5, $9 }' corpus.tsv)"
+out=splitcut.out
+report "splitcut (mmap)" "$(best_ms ./splitcut -d '\t' -o , -f 2,5,9 corpus.tsv)"
+out=splitcut_pipe.out
+report "splitcut (pipe)" "$(best_ms sh -c './splitcut -d "\t" -o , -f 2,5,9 <corpus.tsv | cat')"
+out=splitcut_1.out
+report "splitcut (mmap, 1 thread)" "$(best_ms ./splitcut -j 1 -d '\t' -o , -f 2,5,9 corpus.tsv)"
+
+for f in awk.out splitcut.out splitcut_pipe.out splitcut_1.out; do
+	if ! cmp -s cut.out "$f"; then
+		echo "$f differs from the output of cut" >&2
+		exit 1
+	fi
+done
+echo "outputs identical"
@@ -0,0 +1,92 @@
+#!/bin/sh
+# text_size.sh -- Compares the code size of a program made of several
+# translation units that use split() and join() when each of them includes
+# split.h (header-only) against the same program built in compiled mode,
+# with split.cpp as one more object.  If BASELINE names a directory holding
+# an older split.h, a header-only build against it is measured as well, e.g.
+#
+#	mkdir -p /tmp/base; git show 8740298:split.h >/tmp/base/split.h
+#	BASELINE=/tmp/base bench/text_size.sh
+#
+# Usage: bench/text_size.sh [translation units]
+# Environment: CXX (default c++), CXXFLAGS (default -O2), LDFLAGS, SIZE
+# (default size), BASELINE.
+#
+# Prints the text size, in bytes, of the objects of the translation units
+# (plus split.o in compiled mode) and of the linked program.
+
+set -e
+
+n_units=${1:-8}
+CXX=${CXX:-c++}
+CXXFLAGS=${CXXFLAGS:--O2}
+SIZE=${SIZE:-size}
+src=$(cd "$(dirname "$0")/.." && pwd)
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+cd "$work"
+
+i=0
+while [ $i -lt "$n_units" ]; do
+	cat >unit$i.cpp <<EOF
+#include <string>
+#include <vector>
+#include "split.h"
+std::string unit$i(const std::string &s){
+	auto by_char=org::ppires::split(s, ',');
+	auto by_str=org::ppires::split(s, std::string("::"));
+	by_char.insert(by_char.end(), by_str.begin(), by_str.end());
+	return org::ppires::join(by_char, std::string("|"));
+}
+EOF
+	i=$((i+1))
+done
+{
+	echo '#include <string>'
+	i=0
+	while [ $i -lt "$n_units" ]; do
+		echo "std::string unit$i(const std::string &);"
+		i=$((i+1))
+	done
+	echo 'int main(int argc, char **argv){'
+	echo '	std::string s(argc>1? argv[1]: "a,b::c"), r;'
+	i=0
+	while [ $i -lt "$n_units" ]; do
+		echo "	r+=unit$i(s);"
+		i=$((i+1))
+	done
+	echo '	return r.empty();'
+	echo '}'
+} >main.cpp
+
+# Prints the summed text size of the object files given.
+text_of(){
+	$SIZE "$@" | awk 'NR>1{ t+=$1 } END{ print t }'
+}
+
+# Builds the program in directory $1 with include path $2 and extra flags
+# $3, adding split.cpp when $4 is set, and prints its text sizes.
+build(){
+	mkdir "$1"
+	objs=
+	i=0
+	while [ $i -lt "$n_units" ]; do
+		$CXX -std=c++20 $CXXFLAGS -I"$2" $3 -c unit$i.cpp -o "$1/unit$i.o"
+		objs="$objs $1/unit$i.o"
+		i=$((i+1))
+	done
+	if [ -n "$4" ]; then
+		$CXX -std=c++20 $CXXFLAGS -I"$2" -c "$2/split.cpp" -o "$1/split.o"
+		objs="$objs $1/split.o"
+	fi
+	$CXX -std=c++20 $CXXFLAGS -c main.cpp -o "$1/main.o"
+	$CXX $LDFLAGS $objs "$1/main.o" -o "$1/prog"
+	echo "objects $(text_of $objs), program $(text_of "$1/prog")"
+}
+
+echo "$n_units translation units, text bytes:"
+if [ -n "$BASELINE" ]; then
+	echo "baseline split.h, header-only: $(build baseline "$BASELINE" "")"
+fi
+echo "split.h, header-only:          $(build header "$src" "")"
+echo "split.h, compiled mode:        $(build compiled "$src" -DORG_PPIRES_SPLIT_COMPILED 1)"
@@ -0,0 +1,35 @@
+/*
+	split.cpp -- Optional compiled part of split.h.
+
+	Build this file into a library and define ORG_PPIRES_SPLIT_COMPILED in
+	every translation unit that includes split.h, e.g.
+
+		c++ -std=c++17 -O2 -c split.cpp
+		c++ -std=c++17 -O2 -DORG_PPIRES_SPLIT_COMPILED -c prog.cpp
+		c++ prog.o split.o -o prog
+
+	split.cpp and its users must be compiled with the same language
+	standard, so that the char8_t instantiations match.
+
+	Author: Paulo A. P. Pires
+	Copyright 2018-2020, Paulo A. P. Pires
+
+	This file is temporarily licensed for general use.  Please submit
+	suggestions and improvements back to me, so I can ad them to the
+	repository.
+*/
+
+
+#define ORG_PPIRES_SPLIT_COMPILED
+#define ORG_PPIRES_SPLIT_IMPLEMENTATION
+#include "split.h"
+#include "split_regex.h"
+
+
+namespace org::ppires {
+
+ORG_PPIRES_SPLIT_INSTANTIATE_ALL()
+ORG_PPIRES_SPLIT_INSTANTIATE_CHAR8()
+ORG_PPIRES_SPLIT_INSTANTIATE_REGEX_ALL()
+
+}	// namespace org::ppires.
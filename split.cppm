@@ -0,0 +1,121 @@
+/*
+	split.cppm -- C++20 module interface for split.h.
+
+	Exports everything in split.h, split_cache.h, split_format.h,
+	split_parallel.h and split_posix.h except the regex-based overloads,
+	which are in module org.ppires.split.regex (split_regex.cppm), so that
+	importing this module never compiles <regex>.
+
+	Author: Paulo A. P. Pires
+	Copyright 2018-2020, Paulo A. P. Pires
+
+	This file is temporarily licensed for general use.  Please submit
+	suggestions and improvements back to me, so I can ad them to the
+	repository.
+*/
+
+
+module;
+
+#define ORG_PPIRES_SPLIT_NO_REGEX
+#include "split.h"
+#include "split_cache.h"
+#include "split_format.h"
+#include "split_parallel.h"
+#include "split_posix.h"
+
+export module org.ppires.split;
+
+
+export namespace org::ppires {
+
+using org::ppires::split_max;
+using org::ppires::split;
+using org::ppires::basic_join;
+using org::ppires::join;
+using org::ppires::basic_join_writer;
+using org::ppires::join_writer;
+using org::ppires::wjoin_writer;
+using org::ppires::join_kv;
+using org::ppires::split_sizes;
+using org::ppires::split_size;
+using org::ppires::joined_size;
+#if defined(__cpp_lib_format)
+using org::ppires::joined_range;
+using org::ppires::joined;
+#endif
+
+using org::ppires::project_join;
+using org::ppires::project_join_records;
+
+using org::ppires::split_limits;
+using org::ppires::split_limit;
+using org::ppires::limit_policy;
+using org::ppires::split_limit_error;
+using org::ppires::split_bounded;
+
+using org::ppires::byte_span;
+using org::ppires::split_terminated;
+using org::ppires::split_prefixed;
+using org::ppires::split_varint_prefixed;
+
+using org::ppires::query_param;
+using org::ppires::query_params;
+using org::ppires::split_query;
+
+using org::ppires::header_name_hash;
+using org::ppires::header_field;
+using org::ppires::header_fields;
+using org::ppires::split_headers;
+
+using org::ppires::token;
+using org::ppires::tokenizer;
+
+using org::ppires::field_type;
+using org::ppires::n_field_types;
+using org::ppires::classify_field;
+using org::ppires::type_votes;
+using org::ppires::type_inference;
+using org::ppires::infer_types;
+
+using org::ppires::parsed_fields;
+using org::ppires::parse_integers;
+using org::ppires::parse_floats;
+
+using org::ppires::partition_records;
+using org::ppires::partition_records_copy;
+
+using org::ppires::hyperloglog;
+using org::ppires::n_length_buckets;
+using org::ppires::column_profile;
+using org::ppires::buffer_profile;
+using org::ppires::profile_fields;
+
+using org::ppires::field_count_violation;
+using org::ppires::field_count_report;
+using org::ppires::validate_field_counts;
+
+using org::ppires::basic_splitter;
+using org::ppires::splitter;
+using org::ppires::wsplitter;
+
+using org::ppires::memory_footprint;
+using org::ppires::memory_usage;
+
+using org::ppires::basic_split_cache;
+using org::ppires::split_cache;
+using org::ppires::wsplit_cache;
+
+#if defined(ORG_PPIRES_SPLIT_HAVE_UNISTD)
+using org::ppires::basic_fd_join_writer;
+using org::ppires::fd_join_writer;
+using org::ppires::wfd_join_writer;
+#endif
+
+#if defined(ORG_PPIRES_SPLIT_HAVE_MEMFD)
+using org::ppires::shared_arena;
+using org::ppires::split_shared;
+using org::ppires::shared_split_view;
+#endif
+
+}	// namespace org::ppires.
@@ -19,16 +19,51 @@
 #define ORG_PPIRES_SPLIT_H__
 
 
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <iterator>
 #include <limits>
 #include <locale>
 #include <memory>
-#include <regex>
+#include <numeric>
 #include <sstream>
+#include <stdexcept>
 #include <string>
 #include <string_view>
+#include <system_error>
+#include <type_traits>
 #include <vector>
 
+#if __cplusplus >= 202002L
+#include <bit>
+#include <span>
+#include <version>
+#endif
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+
+// Defining ORG_PPIRES_SPLIT_COMPILED in every translation unit (and linking
+// split.cpp) moves the character-independent core of split(), plus the
+// instantiations for the standard character types, into that one object
+// file instead of repeating them everywhere split.h is included.
+#if defined(ORG_PPIRES_SPLIT_COMPILED)
+#define ORG_PPIRES_SPLIT_INLINE
+#else
+#define ORG_PPIRES_SPLIT_INLINE inline
+#endif
+
+#if !defined(ORG_PPIRES_SPLIT_COMPILED) || defined(ORG_PPIRES_SPLIT_IMPLEMENTATION)
+#define ORG_PPIRES_SPLIT_DEFINE_CORE
+#endif
+
 
 namespace {
 
@@ -42,13 +77,211 @@ namespace org::ppires {
 constexpr size_t split_max=std::numeric_limits<size_t>::max();
 
 
+/****** Internal scanning helpers. ******/
+namespace detail {
+
+constexpr size_t npos=std::numeric_limits<size_t>::max();
+
+// Finds bytes that belong to a small set of byte values.  Where SSE2 is
+// available, sixteen input bytes are compared against every member of the
+// set at once; otherwise (or for sets too large for that), a lookup table
+// is used.
+class byte_set {
+public:
+	static constexpr size_t max_simd_chars=8;
+
+	explicit byte_set(std::string_view chars): n_chars(chars.size()) {
+		for(unsigned char c: chars)
+			table[c]=true;
+#if defined(__SSE2__)
+		for(size_t i=0; i<n_chars && i<max_simd_chars; ++i)
+			simd_chars[i]=_mm_set1_epi8(chars[i]);
+#endif
+	}
+
+	bool contains(char c) const { return table[static_cast<unsigned char>(c)]; }
+
+	const char *find(const char *p, const char *last) const {
+#if defined(__SSE2__)
+		if(n_chars<=max_simd_chars){
+			for(; last-p>=16; p+=16)
+				if(unsigned mask=match_mask(p))
+					return p+__builtin_ctz(mask);
+		}
+#endif
+		for(; p!=last; ++p)
+			if(contains(*p))
+				return p;
+		return last;
+	}
+
+	size_t count(const char *p, const char *last) const {
+		size_t n=0;
+#if defined(__SSE2__)
+		if(n_chars<=max_simd_chars){
+			for(; last-p>=16; p+=16)
+				n+=__builtin_popcount(match_mask(p));
+		}
+#endif
+		for(; p!=last; ++p)
+			n+=contains(*p);
+		return n;
+	}
+
+#if defined(__SSE2__)
+	// Bit i is set if p[i] belongs to the set; requires n_chars<=max_simd_chars.
+	unsigned match_mask(const char *p) const {
+		__m128i block=_mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+		__m128i hits=_mm_setzero_si128();
+		for(size_t i=0; i<n_chars; ++i)
+			hits=_mm_or_si128(hits, _mm_cmpeq_epi8(block, simd_chars[i]));
+		return static_cast<unsigned>(_mm_movemask_epi8(hits));
+	}
+#endif
+
+private:
+	bool table[256]{};
+	size_t n_chars;
+#if defined(__SSE2__)
+	__m128i simd_chars[max_simd_chars];
+#endif
+};
+
+inline int hex_value(char c){
+	if(c>='0' && c<='9')
+		return c-'0';
+	if(c>='a' && c<='f')
+		return c-'a'+10;
+	if(c>='A' && c<='F')
+		return c-'A'+10;
+	return -1;
+}
+
+// Leading zero bits of x, which must not be zero.
+inline unsigned clz64(uint64_t x){
+#if defined(__cpp_lib_bitops)
+	return static_cast<unsigned>(std::countl_zero(x));
+#elif defined(__GNUC__)
+	return static_cast<unsigned>(__builtin_clzll(x));
+#else
+	unsigned n=0;
+	for(uint64_t bit=uint64_t(1)<<63; !(x&bit); bit>>=1)
+		++n;
+	return n;
+#endif
+}
+
+}	// namespace detail
+
+
+/****** Character-independent core of the split functions. ******/
+namespace detail {
+
+// Receives the position and length, in characters, of each field.
+using field_sink=void (*)(void *ctx, size_t pos, size_t len);
+
+// Splits str_len characters of char_size bytes each (1, 2 or 4), comparing
+// them bitwise, as std::char_traits does for the standard character types.
+ORG_PPIRES_SPLIT_INLINE void split_core(
+	const void *str, size_t str_len, const void *sep, size_t sep_len,
+	size_t char_size, size_t max_fields, field_sink sink, void *ctx
+);
+
+template<class char_t, class char_traits_t>
+constexpr bool uses_split_core=
+	std::is_same_v<char_traits_t, std::char_traits<char_t>> &&
+	(sizeof(char_t)==1 || sizeof(char_t)==2 || sizeof(char_t)==4)
+;
+
+template<class result_t, class char_t, class out_ch_alloc_t>
+struct field_collector {
+	result_t &result;
+	const char_t *str;
+	const out_ch_alloc_t &alloc_ch;
+
+	static void sink(void *ctx, size_t pos, size_t len){
+		auto &self=*static_cast<field_collector *>(ctx);
+		self.result.emplace_back(self.str+pos, len, self.alloc_ch);
+	}
+};
+
+#if defined(ORG_PPIRES_SPLIT_DEFINE_CORE)
+template<class unit_t>
+inline void split_units(
+	const unit_t *str_ptr, size_t str_len, const unit_t *sep_ptr, size_t sep_len,
+	size_t max_fields, field_sink sink, void *ctx
+){
+	const std::basic_string_view<unit_t> str(str_ptr, str_len), sep(sep_ptr, sep_len);
+	auto find=[str, sep, sep_len](size_t a){
+		return sep_len==1? str.find(sep[0], a): str.find(sep, a);
+	};
+	const size_t empty_sep=!sep_len;
+	size_t a=0, b, n_fields=0;
+	if(max_fields--){
+		do {
+			b=(n_fields>=max_fields? str.npos: find(a)+empty_sep);
+			sink(ctx, a, std::min(b, str_len)-a);
+			++n_fields;
+			a=b+sep_len;
+		} while(b!=str.npos && a<=str_len);
+	}
+	else {
+		size_t trailing_empty=0;
+		do {
+			b=find(a)+empty_sep;
+			if(b==a)
+				++trailing_empty;
+			else {
+				for(; trailing_empty; --trailing_empty)
+					sink(ctx, a, 0);
+				sink(ctx, a, std::min(b, str_len)-a);
+			}
+			a=b+sep_len;
+		} while(b!=str.npos && a<str_len);
+	}
+}
+
+ORG_PPIRES_SPLIT_INLINE void split_core(
+	const void *str, size_t str_len, const void *sep, size_t sep_len,
+	size_t char_size, size_t max_fields, field_sink sink, void *ctx
+){
+	if(!str_len)
+		return;
+	switch(char_size){
+		case 1:
+			split_units(
+				static_cast<const char *>(str), str_len,
+				static_cast<const char *>(sep), sep_len, max_fields, sink, ctx
+			);
+			break;
+		case 2:
+			split_units(
+				static_cast<const char16_t *>(str), str_len,
+				static_cast<const char16_t *>(sep), sep_len, max_fields, sink, ctx
+			);
+			break;
+		case 4:
+			split_units(
+				static_cast<const char32_t *>(str), str_len,
+				static_cast<const char32_t *>(sep), sep_len, max_fields, sink, ctx
+			);
+			break;
+		default:
+			throw std::invalid_argument("split_core: unsupported character size");
+	}
+}
+#endif
+
+}	// namespace detail
+
+
 /****** Split functions with arguments that are based on std::basic_string_view. ******/
 template<
 	class char_t, class char_traits_t,
 	class out_ch_alloc_t=std::allocator<char_t>,
 	class out_str_alloc_t=std::allocator<std::basic_string<char_t, char_traits_t, out_ch_alloc_t>>
 >
-inline std::vector<std::basic_string<char_t, char_traits_t, out_ch_alloc_t>, out_str_alloc_t>
+ORG_PPIRES_SPLIT_INLINE std::vector<std::basic_string<char_t, char_traits_t, out_ch_alloc_t>, out_str_alloc_t>
 split(
 	const std::basic_string_view<char_t, char_traits_t> str,
 	char_t sep, size_t max_fields=0,
@@ -57,7 +290,11 @@ split(
 ){
 	std::vector<std::basic_string<char_t, char_traits_t, out_ch_alloc_t>, out_str_alloc_t> result;
 	const size_t str_len=str.length();
-	if(str_len){
+	if constexpr(detail::uses_split_core<char_t, char_traits_t>){
+		detail::field_collector<decltype(result), char_t, out_ch_alloc_t> out{result, str.data(), alloc_ch};
+		detail::split_core(str.data(), str_len, &sep, 1, sizeof(char_t), max_fields, out.sink, &out);
+	}
+	else if(str_len){
 		size_t a=0, b;
 		if(max_fields--){
 			do {
@@ -89,7 +326,7 @@ template<
 	class out_ch_alloc_t=std::allocator<char_t>,
 	class out_str_alloc_t=std::allocator<std::basic_string<char_t, char_traits_t, out_ch_alloc_t>>
 >
-inline std::vector<std::basic_string<char_t, char_traits_t, out_ch_alloc_t>, out_str_alloc_t>
+ORG_PPIRES_SPLIT_INLINE std::vector<std::basic_string<char_t, char_traits_t, out_ch_alloc_t>, out_str_alloc_t>
 split(
 	const std::basic_string_view<char_t, char_traits_t> str,
 	const std::basic_string_view<char_t, char_traits_t> sep,
@@ -99,7 +336,14 @@ split(
 ){
 	std::vector<std::basic_string<char_t, char_traits_t, out_ch_alloc_t>, out_str_alloc_t> result;
 	const size_t str_len=str.length();
-	if(str_len){
+	if constexpr(detail::uses_split_core<char_t, char_traits_t>){
+		detail::field_collector<decltype(result), char_t, out_ch_alloc_t> out{result, str.data(), alloc_ch};
+		detail::split_core(
+			str.data(), str_len, sep.data(), sep.length(), sizeof(char_t),
+			max_fields, out.sink, &out
+		);
+	}
+	else if(str_len){
 		const size_t sep_len=sep.length();
 		const size_t empty_sep=!sep_len;
 		size_t a=0, b;
@@ -128,227 +372,6 @@ split(
 	return result;
 }
 
-template<
-	class char_t, class char_traits_t,
-	class regex_traits_t,
-	class out_ch_alloc_t=std::allocator<char_t>,
-	class out_str_alloc_t=std::allocator<std::basic_string<char_t, char_traits_t, out_ch_alloc_t>>
->
-inline std::vector<std::basic_string<char_t, char_traits_t, out_ch_alloc_t>, out_str_alloc_t>
-split(
-	const std::basic_string_view<char_t, char_traits_t> str,
-	const std::basic_regex<char_t, regex_traits_t> &sep_re,
-	size_t max_fields=0,
-	const out_ch_alloc_t &alloc_ch=out_ch_alloc_t(),
-	const out_str_alloc_t &alloc_str=out_str_alloc_t()
-){
-	std::vector<std::basic_string<char_t, char_traits_t, out_ch_alloc_t>, out_str_alloc_t> result;
-	const size_t str_len=str.length();
-	if(str_len){
-		std::match_results<decltype(str.begin())> sep;
-		auto a=str.cbegin();
-		if(max_fields--){
-			auto b=a;
-			do {
-				size_t sep_len=0;
-				if(
-					result.size()<max_fields &&
-					regex_search(a, str.end(), sep, sep_re)
-				){
-					sep_len=sep.length(0);
-					b=a+sep.position(0)+!sep_len;
-				}
-				else
-					b=str.cend();
-				result.emplace_back(a, b, alloc_ch);
-				a=b+sep_len;
-			} while(a!=str.cend());
-			if(b!=str.cend() && result.size()<max_fields)
-				result.emplace_back(alloc_ch);
-		}
-		else {
-			size_t trailing_empty=0;
-			do {
-				auto b=a;
-				size_t sep_len=0;
-				if(regex_search(a, str.end(), sep, sep_re)){
-					sep_len=sep.length(0);
-					b=a+sep.position(0)+!sep_len;
-				}
-				else
-					b=str.cend();
-				if(b==a)
-					++trailing_empty;
-				else {
-					for(; trailing_empty; --trailing_empty)
-						result.emplace_back();
-					result.emplace_back(a, b, alloc_ch);
-				}
-				a=b+sep_len;
-			} while(a!=str.cend());
-		}
-	}
-	return result;
-}
-
-#if 0	// Waiting for C++20's concepts
-template<
-	class char_t, class char_traits_t,
-	class out_ch_alloc_t=std::allocator<char_t>,
-	class out_str_alloc_t=std::allocator<std::basic_string<char_t, char_traits_t, out_ch_alloc_t>>
->
-inline std::vector<std::basic_string<char_t, char_traits_t, out_ch_alloc_t>, out_str_alloc_t>
-split(
-	const std::basic_string_view<char_t, char_traits_t> str,
-	const out_ch_alloc_t &alloc_ch=out_ch_alloc_t(),
-	const out_str_alloc_t &alloc_str=out_str_alloc_t()
-){
-	static const char sep_re_8[]="\\s+";
-	static std::unique_ptr<std::basic_regex<char_t>> sep_re;
-	if(!sep_re){
-		auto &converter=std::use_facet<std::codecvt<char_t, char, std::mbstate_t>>(std::locale());
-		std::mbstate_t mbs{};
-		std::basic_string<char_t, char_traits_t> sep_str(sizeof sep_re_8, char_t());
-		const char *from_next;
-		char_t *to_next;
-		converter.in(
-			mbs,
-			sep_re_8, sep_re_8+sizeof sep_re_8, from_next,
-			&sep_str[0], &sep_str[sep_str.size()], to_next
-		);
-		sep_str.resize(to_next-&sep_str[0]);
-		sep_re.reset(new std::basic_regex<char_t>(sep_str));
-	}
-	return split(str, *sep_re, 0, alloc_ch, alloc_str);
-}
-
-template<
-	class char_traits_t,
-	class out_ch_alloc_t=std::allocator<char>,
-	class out_str_alloc_t=std::allocator<std::basic_string<char, char_traits_t, out_ch_alloc_t>>
->
-inline std::vector<std::basic_string<char, char_traits_t, out_ch_alloc_t>, out_str_alloc_t>
-split(
-	const std::basic_string_view<char, char_traits_t> str,
-	const out_ch_alloc_t &alloc_ch=out_ch_alloc_t(),
-	const out_str_alloc_t &alloc_str=out_str_alloc_t()
-){
-	return split(str, std::regex("\\s+"), 0, alloc_ch, alloc_str);
-}
-
-template<
-	class char_traits_t,
-	class out_ch_alloc_t=std::allocator<wchar_t>,
-	class out_str_alloc_t=std::allocator<std::basic_string<wchar_t, char_traits_t, out_ch_alloc_t>>
->
-inline std::vector<std::basic_string<wchar_t, char_traits_t, out_ch_alloc_t>, out_str_alloc_t>
-split(
-	const std::basic_string_view<wchar_t, char_traits_t> str,
-	const out_ch_alloc_t &alloc_ch=out_ch_alloc_t(),
-	const out_str_alloc_t &alloc_str=out_str_alloc_t()
-){
-	return split(str, std::wregex(L"\\s+"), 0, alloc_ch, alloc_str);
-}
-
-template<
-	class char_traits_t,
-	class out_ch_alloc_t=std::allocator<char32_t>,
-	class out_str_alloc_t=std::allocator<std::basic_string<char32_t, char_traits_t, out_ch_alloc_t>>
->
-inline std::vector<std::basic_string<char32_t, char_traits_t, out_ch_alloc_t>, out_str_alloc_t>
-split(
-	const std::basic_string_view<char32_t, char_traits_t> str,
-	const out_ch_alloc_t &alloc_ch=out_ch_alloc_t(),
-	const out_str_alloc_t &alloc_str=out_str_alloc_t()
-){
-	return split(str, std::basic_regex<char32_t>(U"\\s+"), 0, alloc_ch, alloc_str);
-}
-
-template<
-	class char_traits_t,
-	class out_ch_alloc_t=std::allocator<char16_t>,
-	class out_str_alloc_t=std::allocator<std::basic_string<char16_t, char_traits_t, out_ch_alloc_t>>
->
-inline std::vector<std::basic_string<char16_t, char_traits_t, out_ch_alloc_t>, out_str_alloc_t>
-split(
-	const std::basic_string_view<char16_t, char_traits_t> str,
-	const out_ch_alloc_t &alloc_ch=out_ch_alloc_t(),
-	const out_str_alloc_t &alloc_str=out_str_alloc_t()
-){
-	return split(str, std::basic_regex<char16_t>(u"\\s+"), 0, alloc_ch, alloc_str);
-}
-
-#if __cplusplus >= 202002L
-template<
-	class char_traits_t,
-	class out_ch_alloc_t=std::allocator<char8_t>,
-	class out_str_alloc_t=std::allocator<std::basic_string<char8_t, char_traits_t, out_ch_alloc_t>>
->
-inline std::vector<std::basic_string<char8_t, char_traits_t, out_ch_alloc_t>, out_str_alloc_t>
-split(
-	const std::basic_string_view<char8_t, char_traits_t> str,
-	const out_ch_alloc_t &alloc_ch=out_ch_alloc_t(),
-	const out_str_alloc_t &alloc_str=out_str_alloc_t()
-){
-	return split(str, std::basic_regex<char8_t>(u8"\\s+"), 0, alloc_ch, alloc_str);
-}
-#endif
-#else
-template<class char_t, class char_traits_t>
-inline std::vector<std::basic_string<char_t, char_traits_t>>
-split(const std::basic_string_view<char_t, char_traits_t> str){
-	static const char sep_re_8[]="\\s+";
-	static std::unique_ptr<std::basic_regex<char_t>> sep_re;
-	if(!sep_re){
-		auto &converter=std::use_facet<std::codecvt<char_t, char, std::mbstate_t>>(std::locale());
-		std::mbstate_t mbs{};
-		std::basic_string<char_t, char_traits_t> sep_str(sizeof sep_re_8, char_t());
-		const char *from_next;
-		char_t *to_next;
-		converter.in(
-			mbs,
-			sep_re_8, sep_re_8+sizeof sep_re_8, from_next,
-			&sep_str[0], &sep_str[sep_str.size()], to_next
-		);
-		sep_str.resize(to_next-&sep_str[0]);
-		sep_re.reset(new std::basic_regex<char_t>(sep_str));
-	}
-	return split(str, *sep_re, 0);
-}
-
-template<class char_traits_t>
-inline std::vector<std::basic_string<char, char_traits_t>>
-split(const std::basic_string_view<char, char_traits_t> str){
-	return split(str, std::regex("\\s+"), 0);
-}
-
-template<class char_traits_t>
-inline std::vector<std::basic_string<wchar_t, char_traits_t>>
-split(const std::basic_string_view<wchar_t, char_traits_t> str){
-	return split(str, std::wregex(L"\\s+"), 0);
-}
-
-template<class char_traits_t>
-inline std::vector<std::basic_string<char32_t, char_traits_t>>
-split(const std::basic_string_view<char32_t, char_traits_t> str){
-	return split(str, std::basic_regex<char32_t>(U"\\s+"), 0);
-}
-
-template<class char_traits_t>
-inline std::vector<std::basic_string<char16_t, char_traits_t>>
-split(const std::basic_string_view<char16_t, char_traits_t> str){
-	return split(str, std::basic_regex<char16_t>(u"\\s+"), 0);
-}
-
-#if __cplusplus >= 202002L
-template<class char_traits_t>
-inline std::vector<std::basic_string<char8_t, char_traits_t>>
-split(	const std::basic_string_view<char8_t, char_traits_t> str){
-	return split(str, std::basic_regex<char8_t>(u8"\\s+"), 0);
-}
-#endif
-#endif
-
 
 /****** Split functions with at least one argument based on std::basic_string. ******/
 template<
@@ -440,56 +463,6 @@ split(
 	;
 }
 
-template<
-	class char_t, class char_traits_t,
-	class regex_traits_t,
-	class in_ch_alloc_t, class out_ch_alloc_t=in_ch_alloc_t,
-	class out_str_alloc_t=std::allocator<std::basic_string<char_t, char_traits_t, out_ch_alloc_t>>
->
-inline std::vector<std::basic_string<char_t, char_traits_t, out_ch_alloc_t>, out_str_alloc_t>
-split(
-	const std::basic_string<char_t, char_traits_t, in_ch_alloc_t> &str,
-	const std::basic_regex<char_t, regex_traits_t> &sep_re,
-	size_t max_fields=0,
-	const out_ch_alloc_t &alloc_ch=out_ch_alloc_t(),
-	const out_str_alloc_t &alloc_str=out_str_alloc_t()
-){
-	return
-		split(
-			std::basic_string_view<char_t, char_traits_t>(str),
-			sep_re, max_fields,
-			alloc_ch, alloc_str
-		)
-	;
-}
-
-#if 0	// Waiting for C++-20 concepts.
-template<
-	class char_t, class char_traits_t,
-	class in_ch_alloc_t, class out_ch_alloc_t=in_ch_alloc_t,
-	class out_str_alloc_t=std::allocator<std::basic_string<char_t, char_traits_t, out_ch_alloc_t>>
->
-inline std::vector<std::basic_string<char_t, char_traits_t, out_ch_alloc_t>, out_str_alloc_t>
-split(
-	const std::basic_string<char_t, char_traits_t, in_ch_alloc_t> &str,
-	const out_ch_alloc_t &alloc_ch=out_ch_alloc_t(),
-	const out_str_alloc_t &alloc_str=out_str_alloc_t()
-){
-	return
-		split(
-			std::basic_string_view<char_t, char_traits_t>(str),
-			alloc_ch, alloc_str
-		)
-	;
-}
-#else
-template<class char_t, class char_traits_t, class in_ch_alloc_t>
-inline std::vector<std::basic_string<char_t, char_traits_t>>
-split(const std::basic_string<char_t, char_traits_t, in_ch_alloc_t> &str){
-	return split(std::basic_string_view<char_t, char_traits_t>(str));
-}
-#endif
-
 
 /****** Split functions with argument(s) that is(are) pointer(s) to characters ******/
 template<
@@ -576,37 +549,30 @@ split(
 	;
 }
 
+
+/****** Split functions with mixed character pointers and std::basic_string arguments ******/
 template<
-	class char_t, class char_traits_t=std::char_traits<char_t>,
-	class regex_traits_t,
-	class out_ch_alloc_t=std::allocator<char_t>,
+	class char_t, class char_traits_t,
+	class in_ch_alloc_t, class out_ch_alloc_t=in_ch_alloc_t,
 	class out_str_alloc_t=std::allocator<std::basic_string<char_t, char_traits_t, out_ch_alloc_t>>
 >
 inline std::vector<std::basic_string<char_t, char_traits_t, out_ch_alloc_t>, out_str_alloc_t>
 split(
-	const char_t *str, const std::basic_regex<char_t, regex_traits_t> &sep_re,
+	const char_t *str,
+	const std::basic_string<char_t, char_traits_t, in_ch_alloc_t> &sep,
 	size_t max_fields=0,
-	const char_traits_t trait_obj=char_traits_t(),
 	const out_ch_alloc_t &alloc_ch=out_ch_alloc_t(),
 	const out_str_alloc_t &alloc_str=out_str_alloc_t()
 ){
 	return
 		split(
 			std::basic_string_view<char_t, char_traits_t>(str),
-			sep_re, max_fields,
+			std::basic_string_view<char_t, char_traits_t>(sep), max_fields,
 			alloc_ch, alloc_str
 		)
 	;
 }
 
-template<class char_t, class char_traits_t=std::char_traits<char_t>>
-inline std::vector<std::basic_string<char_t, char_traits_t>>
-split(const char_t *str){
-	return split(std::basic_string_view<char_t, char_traits_t>(str));
-}
-
-
-/****** Split functions with mixed character pointers and std::basic_string arguments ******/
 template<
 	class char_t, class char_traits_t,
 	class in_ch_alloc_t, class out_ch_alloc_t=in_ch_alloc_t,
@@ -614,75 +580,1668 @@ template<
 >
 inline std::vector<std::basic_string<char_t, char_traits_t, out_ch_alloc_t>, out_str_alloc_t>
 split(
-	const char_t *str,
-	const std::basic_string<char_t, char_traits_t, in_ch_alloc_t> &sep,
-	size_t max_fields=0,
+	const std::basic_string<char_t, char_traits_t, in_ch_alloc_t> &str,
+	const char_t *sep, size_t max_fields=0,
 	const out_ch_alloc_t &alloc_ch=out_ch_alloc_t(),
 	const out_str_alloc_t &alloc_str=out_str_alloc_t()
 ){
 	return
 		split(
-			std::basic_string_view<char_t, char_traits_t>(str),
+			str,
 			std::basic_string_view<char_t, char_traits_t>(sep), max_fields,
 			alloc_ch, alloc_str
 		)
 	;
 }
 
-template<
-	class char_t, class char_traits_t,
-	class in_ch_alloc_t, class out_ch_alloc_t=in_ch_alloc_t,
-	class out_str_alloc_t=std::allocator<std::basic_string<char_t, char_traits_t, out_ch_alloc_t>>
->
-inline std::vector<std::basic_string<char_t, char_traits_t, out_ch_alloc_t>, out_str_alloc_t>
-split(
-	const std::basic_string<char_t, char_traits_t, in_ch_alloc_t> &str,
-	const char_t *sep, size_t max_fields=0,
-	const out_ch_alloc_t &alloc_ch=out_ch_alloc_t(),
-	const out_str_alloc_t &alloc_str=out_str_alloc_t()
+
+
+
+/****** Split functions with resource limits. ******/
+// Bounds for split_bounded(), meant for input that may be hostile.  Byte
+// counts are of field characters, i.e. characters times sizeof(char_t).
+struct split_limits {
+	size_t max_fields=split_max;
+	size_t max_bytes=split_max;
+	size_t max_field_length=split_max;	// In characters.
+};
+
+enum class split_limit { none, fields, bytes, field_length };
+
+// What split_bounded() does when the input exceeds a limit: refuse throws
+// split_limit_error before any field is allocated; truncate returns only
+// the fields (and parts of fields) that fit.  Either way, the limit
+// reported is the same.
+enum class limit_policy { refuse, truncate };
+
+class split_limit_error: public std::length_error {
+public:
+	explicit split_limit_error(split_limit which):
+		std::length_error("split_bounded: input exceeds split limits"), limit(which)
+	{ }
+
+	split_limit which() const { return limit; }
+
+private:
+	split_limit limit;
+};
+
+namespace detail {
+
+struct field_tally {
+	size_t fields=0, chars=0, longest=0;
+
+	static void sink(void *ctx, size_t, size_t len){
+		auto &self=*static_cast<field_tally *>(ctx);
+		++self.fields;
+		self.chars+=len;
+		self.longest=std::max(self.longest, len);
+	}
+};
+
+// Counts fields and characters without producing them.  With a one-char
+// separator, only a vectorised count of separators is needed; longer
+// separators, or a bound on field length, need the field boundaries.
+template<class char_t>
+inline field_tally tally_fields(
+	std::basic_string_view<char_t> str, std::basic_string_view<char_t> sep, bool need_longest
+){
+	field_tally t;
+	if constexpr(sizeof(char_t)==1){
+		if(sep.size()==1 && !need_longest){
+			// split() drops trailing empty fields, so trailing separators do
+			// not count.
+			const size_t len=str.find_last_not_of(sep[0])+1;
+			if(len){
+				auto p=reinterpret_cast<const char *>(str.data());
+				const size_t n_seps=
+					byte_set(std::string_view(reinterpret_cast<const char *>(sep.data()), 1)).count(p, p+len)
+				;
+				t.fields=n_seps+1;
+				t.chars=len-n_seps;
+			}
+			return t;
+		}
+	}
+	split_core(str.data(), str.size(), sep.data(), sep.size(), sizeof(char_t), 0, t.sink, &t);
+	return t;
+}
+
+template<class result_t, class char_t, class out_ch_alloc_t>
+struct bounded_collector {
+	result_t &result;
+	const char_t *str;
+	const out_ch_alloc_t &alloc_ch;
+	const split_limits &limits;
+	size_t chars=0;
+
+	static void sink(void *ctx, size_t pos, size_t len){
+		auto &self=*static_cast<bounded_collector *>(ctx);
+		const size_t max_chars=self.limits.max_bytes/sizeof(char_t);
+		if(self.result.size()>=self.limits.max_fields || self.chars>=max_chars)
+			return;
+		len=std::min({len, self.limits.max_field_length, max_chars-self.chars});
+		self.chars+=len;
+		self.result.emplace_back(self.str+pos, len, self.alloc_ch);
+	}
+};
+
+template<class char_t, class out_ch_alloc_t>
+inline std::vector<std::basic_string<char_t, std::char_traits<char_t>, out_ch_alloc_t>>
+split_bounded(
+	std::basic_string_view<char_t> str, std::basic_string_view<char_t> sep,
+	const split_limits &limits, limit_policy policy, split_limit *hit,
+	const out_ch_alloc_t &alloc_ch
+){
+	static_assert(
+		uses_split_core<char_t, std::char_traits<char_t>>,
+		"split_bounded() needs a standard character type"
+	);
+	std::vector<std::basic_string<char_t, std::char_traits<char_t>, out_ch_alloc_t>> result;
+	const auto t=tally_fields(str, sep, limits.max_field_length!=split_max);
+	split_limit exceeded=split_limit::none;
+	if(t.fields>limits.max_fields)
+		exceeded=split_limit::fields;
+	else if(t.chars>limits.max_bytes/sizeof(char_t))
+		exceeded=split_limit::bytes;
+	else if(t.longest>limits.max_field_length)
+		exceeded=split_limit::field_length;
+	if(hit)
+		*hit=exceeded;
+	if(exceeded==split_limit::none){
+		result.reserve(t.fields);
+		field_collector<decltype(result), char_t, out_ch_alloc_t> out{result, str.data(), alloc_ch};
+		split_core(str.data(), str.size(), sep.data(), sep.size(), sizeof(char_t), 0, out.sink, &out);
+	}
+	else if(policy==limit_policy::refuse)
+		throw split_limit_error(exceeded);
+	else {
+		result.reserve(std::min(t.fields, limits.max_fields));
+		bounded_collector<decltype(result), char_t, out_ch_alloc_t> out{result, str.data(), alloc_ch, limits};
+		split_core(str.data(), str.size(), sep.data(), sep.size(), sizeof(char_t), 0, out.sink, &out);
+	}
+	return result;
+}
+
+}	// namespace detail
+
+// Like split() with max_fields=0, but the number of fields, the bytes in
+// all fields and the length of each field are checked against limits
+// before anything is allocated.  If hit is not null, it receives the limit
+// that was exceeded, or split_limit::none; when several were, fields wins
+// over bytes, and bytes over field_length, with either policy.
+template<class char_t, class out_ch_alloc_t=std::allocator<char_t>>
+inline std::vector<std::basic_string<char_t, std::char_traits<char_t>, out_ch_alloc_t>>
+split_bounded(
+	std::basic_string_view<char_t> str, char_t sep,
+	const split_limits &limits, limit_policy policy=limit_policy::refuse,
+	split_limit *hit=nullptr,
+	const out_ch_alloc_t &alloc_ch=out_ch_alloc_t()
+){
+	return
+		detail::split_bounded(
+			str, std::basic_string_view<char_t>(&sep, 1),
+			limits, policy, hit, alloc_ch
+		)
+	;
+}
+
+template<class char_t, class out_ch_alloc_t=std::allocator<char_t>>
+inline std::vector<std::basic_string<char_t, std::char_traits<char_t>, out_ch_alloc_t>>
+split_bounded(
+	std::basic_string_view<char_t> str, std::basic_string_view<char_t> sep,
+	const split_limits &limits, limit_policy policy=limit_policy::refuse,
+	split_limit *hit=nullptr,
+	const out_ch_alloc_t &alloc_ch=out_ch_alloc_t()
+){
+	return detail::split_bounded(str, sep, limits, policy, hit, alloc_ch);
+}
+
+template<class char_t, class in_ch_alloc_t, class out_ch_alloc_t=std::allocator<char_t>>
+inline std::vector<std::basic_string<char_t, std::char_traits<char_t>, out_ch_alloc_t>>
+split_bounded(
+	const std::basic_string<char_t, std::char_traits<char_t>, in_ch_alloc_t> &str, char_t sep,
+	const split_limits &limits, limit_policy policy=limit_policy::refuse,
+	split_limit *hit=nullptr,
+	const out_ch_alloc_t &alloc_ch=out_ch_alloc_t()
+){
+	return
+		detail::split_bounded(
+			std::basic_string_view<char_t>(str), std::basic_string_view<char_t>(&sep, 1),
+			limits, policy, hit, alloc_ch
+		)
+	;
+}
+
+template<class char_t, class in_ch_alloc_t, class out_ch_alloc_t=std::allocator<char_t>>
+inline std::vector<std::basic_string<char_t, std::char_traits<char_t>, out_ch_alloc_t>>
+split_bounded(
+	const std::basic_string<char_t, std::char_traits<char_t>, in_ch_alloc_t> &str,
+	std::basic_string_view<char_t> sep,
+	const split_limits &limits, limit_policy policy=limit_policy::refuse,
+	split_limit *hit=nullptr,
+	const out_ch_alloc_t &alloc_ch=out_ch_alloc_t()
+){
+	return
+		detail::split_bounded(
+			std::basic_string_view<char_t>(str), sep,
+			limits, policy, hit, alloc_ch
+		)
+	;
+}
+
+
+#if __cplusplus >= 202002L
+/****** Split functions for binary buffers based on std::span<const std::byte>. ******/
+using byte_span=std::span<const std::byte>;
+
+namespace detail {
+
+inline size_t find_byte(byte_span buf, std::byte sep, size_t from){
+	if(from>=buf.size())
+		return npos;
+	auto p=static_cast<const std::byte *>(
+		std::memchr(buf.data()+from, std::to_integer<unsigned char>(sep), buf.size()-from)
+	);
+	return p? size_t(p-buf.data()): npos;
+}
+
+inline size_t find_bytes(byte_span buf, byte_span sep, size_t from){
+	const size_t sep_len=sep.size();
+	if(!sep_len)
+		return from<=buf.size()? from: npos;
+	while(from<buf.size() && buf.size()-from>=sep_len){
+		size_t pos=find_byte(buf.first(buf.size()-sep_len+1), sep[0], from);
+		if(pos==npos)
+			break;
+		if(!std::memcmp(buf.data()+pos+1, sep.data()+1, sep_len-1))
+			return pos;
+		from=pos+1;
+	}
+	return npos;
+}
+
+// Mirrors the algorithm of the character-based split(), including Perl's
+// treatment of max_fields and of trailing empty fields.
+template<class find_sep_t>
+inline std::vector<byte_span>
+split_bytes(byte_span buf, find_sep_t find_sep, size_t sep_len, size_t max_fields){
+	std::vector<byte_span> result;
+	const size_t buf_len=buf.size();
+	if(buf_len){
+		const size_t empty_sep=!sep_len;
+		size_t a=0, b;
+		if(max_fields--){
+			do {
+				b=(result.size()>=max_fields? npos: find_sep(a)+empty_sep);
+				result.emplace_back(buf.subspan(a, std::min(b, buf_len)-a));
+				a=b+sep_len;
+			} while(b!=npos && a<=buf_len);
+		}
+		else {
+			size_t trailing_empty=0;
+			do {
+				b=find_sep(a)+empty_sep;
+				if(b==a)
+					++trailing_empty;
+				else {
+					for(; trailing_empty; --trailing_empty)
+						result.emplace_back();
+					result.emplace_back(buf.subspan(a, std::min(b, buf_len)-a));
+				}
+				a=b+sep_len;
+			} while(b!=npos && a<buf_len);
+		}
+	}
+	return result;
+}
+
+// Records delimited by a terminator.  When consumed is given, an unterminated
+// tail is left for the next chunk; otherwise it becomes the last record.
+template<class find_sep_t>
+inline std::vector<byte_span>
+split_terminated_bytes(
+	byte_span buf, find_sep_t find_sep, size_t sep_len, size_t *consumed
+){
+	std::vector<byte_span> result;
+	const size_t buf_len=buf.size();
+	size_t a=0, b;
+	while(a<buf_len && (b=find_sep(a))!=npos){
+		result.emplace_back(buf.subspan(a, b-a));
+		a=b+sep_len;
+	}
+	if(consumed)
+		*consumed=a;
+	else if(a<buf_len)
+		result.emplace_back(buf.subspan(a));
+	return result;
+}
+
+inline void finish_framing(size_t a, size_t buf_len, size_t *consumed){
+	if(consumed)
+		*consumed=a;
+	else if(a!=buf_len)
+		throw std::length_error("split: truncated record at end of buffer");
+}
+
+// Reads one unsigned LEB128 value (the varint encoding used by Protocol
+// Buffers).  Returns false if the buffer ends before the value does.
+inline bool read_varint(byte_span buf, size_t &pos, uint64_t &value){
+	value=0;
+	unsigned shift=0;
+	for(size_t i=pos; i<buf.size(); shift+=7, ++i){
+		auto byte=std::to_integer<uint64_t>(buf[i]);
+		if(shift==63 && byte>1)
+			throw std::overflow_error("split: varint length prefix exceeds 64 bits");
+		value|=(byte&0x7f)<<shift;
+		if(!(byte&0x80)){
+			pos=i+1;
+			return true;
+		}
+	}
+	return false;
+}
+
+}	// namespace detail
+
+inline std::vector<byte_span>
+split(byte_span buf, std::byte sep, size_t max_fields=0){
+	return
+		detail::split_bytes(
+			buf,
+			[buf, sep](size_t from){ return detail::find_byte(buf, sep, from); },
+			1, max_fields
+		)
+	;
+}
+
+inline std::vector<byte_span>
+split(byte_span buf, byte_span sep, size_t max_fields=0){
+	return
+		detail::split_bytes(
+			buf,
+			[buf, sep](size_t from){ return detail::find_bytes(buf, sep, from); },
+			sep.size(), max_fields
+		)
+	;
+}
+
+// Streaming-friendly forms.  Every record ends with sep, and empty records
+// are kept.  If consumed is not null, an incomplete last record is not
+// returned, and *consumed receives the offset where the next chunk must
+// resume.
+inline std::vector<byte_span>
+split_terminated(byte_span buf, std::byte sep, size_t *consumed=nullptr){
+	return
+		detail::split_terminated_bytes(
+			buf,
+			[buf, sep](size_t from){ return detail::find_byte(buf, sep, from); },
+			1, consumed
+		)
+	;
+}
+
+inline std::vector<byte_span>
+split_terminated(byte_span buf, byte_span sep, size_t *consumed=nullptr){
+	if(sep.empty())
+		throw std::invalid_argument("split_terminated: empty terminator");
+	return
+		detail::split_terminated_bytes(
+			buf,
+			[buf, sep](size_t from){ return detail::find_bytes(buf, sep, from); },
+			sep.size(), consumed
+		)
+	;
+}
+
+// Records preceded by an unsigned length of prefix_width bytes (1 to 8).
+// Without consumed, a truncated last record throws std::length_error.
+inline std::vector<byte_span>
+split_prefixed(
+	byte_span buf, size_t prefix_width,
+	std::endian order=std::endian::big, size_t *consumed=nullptr
+){
+	if(prefix_width<1 || prefix_width>sizeof(uint64_t))
+		throw std::invalid_argument("split_prefixed: prefix width must be between 1 and 8");
+	std::vector<byte_span> result;
+	const size_t buf_len=buf.size();
+	size_t a=0;
+	while(buf_len-a>=prefix_width){
+		uint64_t len=0;
+		for(size_t i=0; i<prefix_width; ++i)
+			len=(len<<8) | std::to_integer<uint64_t>(
+				buf[a+(order==std::endian::big? i: prefix_width-1-i)]
+			);
+		if(len>buf_len-a-prefix_width)
+			break;
+		result.emplace_back(buf.subspan(a+prefix_width, len));
+		a+=prefix_width+len;
+	}
+	detail::finish_framing(a, buf_len, consumed);
+	return result;
+}
+
+// Records preceded by their length encoded as an unsigned LEB128 varint.
+inline std::vector<byte_span>
+split_varint_prefixed(byte_span buf, size_t *consumed=nullptr){
+	std::vector<byte_span> result;
+	const size_t buf_len=buf.size();
+	size_t a=0;
+	while(a<buf_len){
+		size_t b=a;
+		uint64_t len;
+		if(!detail::read_varint(buf, b, len) || len>buf_len-b)
+			break;
+		result.emplace_back(buf.subspan(b, len));
+		a=b+len;
+	}
+	detail::finish_framing(a, buf_len, consumed);
+	return result;
+}
+#endif
+
+
+/****** Split function for URL query strings. ******/
+struct query_param {
+	std::string_view name;
+	std::string_view value;
+};
+
+// Result of split_query().  Fields that needed no decoding are views into
+// the input string, which must outlive this object; decoded fields live in
+// an arena owned by it.  Moving keeps every view valid.
+class query_params {
+public:
+	using value_type=query_param;
+	using const_iterator=std::vector<query_param>::const_iterator;
+
+	query_params()=default;
+	query_params(query_params &&)=default;
+	query_params &operator=(query_params &&)=default;
+
+	size_t size() const { return params.size(); }
+	bool empty() const { return params.empty(); }
+	const query_param &operator[](size_t n) const { return params[n]; }
+	const_iterator begin() const { return params.begin(); }
+	const_iterator end() const { return params.end(); }
+
+	size_t capacity() const { return params.capacity(); }
+	size_t arena_capacity() const { return arena? arena_size: 0; }
+
+private:
+	friend query_params split_query(std::string_view str);
+
+	std::vector<query_param> params;
+	std::unique_ptr<char[]> arena;
+	size_t arena_size=0;
+};
+
+// Splits "a=1&b=hello%20world" into name/value pairs, decoding "%XX" and
+// "+" in the same pass that finds the '&' and '=' boundaries.  Empty
+// fields are skipped, a field without '=' gets an empty value, and
+// malformed escapes are kept verbatim.
+inline query_params split_query(std::string_view str){
+	static const detail::byte_set delims("&=%+");
+	query_params result;
+	const char *const first=str.data(), *const last=first+str.size();
+	char *out=nullptr;
+	auto decode=[&](const char *a, const char *b, bool dirty){
+		if(!dirty)
+			return std::string_view(a, b-a);
+		if(!out){
+			// Decoding never makes a field longer, so one block the size of
+			// the input is enough for every field.
+			result.arena.reset(new char[str.size()]);
+			result.arena_size=str.size();
+			out=result.arena.get();
+		}
+		char *const start=out;
+		while(a!=b){
+			char c=*a++;
+			if(c=='+')
+				c=' ';
+			else if(c=='%' && b-a>=2){
+				int hi=detail::hex_value(a[0]), lo=detail::hex_value(a[1]);
+				if(hi>=0 && lo>=0){
+					c=static_cast<char>(hi<<4 | lo);
+					a+=2;
+				}
+			}
+			*out++=c;
+		}
+		return std::string_view(start, out-start);
+	};
+
+	const char *field=first, *eq=nullptr;
+	bool name_dirty=false, dirty=false;
+	auto emit=[&](const char *end){
+		if(end==field)
+			return;
+		if(eq)
+			result.params.push_back({decode(field, eq, name_dirty), decode(eq+1, end, dirty)});
+		else
+			result.params.push_back({decode(field, end, dirty), std::string_view(end, 0)});
+	};
+	for(const char *p=first; ; ++p){
+		p=delims.find(p, last);
+		if(p==last){
+			emit(last);
+			break;
+		}
+		switch(*p){
+			case '&':
+				emit(p);
+				field=p+1;
+				eq=nullptr;
+				name_dirty=dirty=false;
+				break;
+			case '=':
+				if(!eq){
+					eq=p;
+					name_dirty=dirty;
+					dirty=false;
+				}
+				break;
+			default:
+				dirty=true;
+		}
+	}
+	return result;
+}
+
+
+/****** Split function for HTTP/MIME header blocks. ******/
+namespace detail {
+
+inline char ascii_lower(char c){
+	return (c>='A' && c<='Z')? char(c|0x20): c;
+}
+
+inline bool is_ows(char c){
+	return c==' ' || c=='\t';
+}
+
+constexpr uint64_t fnv1a_basis=0xcbf29ce484222325ull;
+constexpr uint64_t fnv1a_prime=0x100000001b3ull;
+
+inline uint64_t fnv1a_lower(uint64_t h, char c){
+	return (h^static_cast<unsigned char>(ascii_lower(c)))*fnv1a_prime;
+}
+
+}	// namespace detail
+
+// FNV-1a hash of an ASCII string, ignoring letter case; split_headers()
+// stores this value for each header name.
+inline uint64_t header_name_hash(std::string_view name){
+	uint64_t h=detail::fnv1a_basis;
+	for(char c: name)
+		h=detail::fnv1a_lower(h, c);
+	return h;
+}
+
+struct header_field {
+	std::string_view name;
+	std::string_view value;
+	uint64_t name_hash;
+};
+
+// Result of split_headers().  Names, and values that were not folded, are
+// views into the input block, which must outlive this object; folded values
+// live in an arena owned by it.
+class header_fields {
+public:
+	using value_type=header_field;
+	using const_iterator=std::vector<header_field>::const_iterator;
+
+	header_fields()=default;
+	header_fields(header_fields &&)=default;
+	header_fields &operator=(header_fields &&)=default;
+
+	size_t size() const { return fields.size(); }
+	bool empty() const { return fields.empty(); }
+	const header_field &operator[](size_t n) const { return fields[n]; }
+	const_iterator begin() const { return fields.begin(); }
+	const_iterator end() const { return fields.end(); }
+
+	size_t capacity() const { return fields.capacity(); }
+	size_t arena_capacity() const { return arena? arena_size: 0; }
+
+	// First field with the given name (compared without regard to ASCII
+	// letter case), or nullptr.
+	const header_field *find(std::string_view name) const {
+		const uint64_t h=header_name_hash(name);
+		for(auto &f: fields){
+			if(
+				f.name_hash==h && f.name.size()==name.size() &&
+				std::equal(
+					name.begin(), name.end(), f.name.begin(),
+					[](char a, char b){ return detail::ascii_lower(a)==detail::ascii_lower(b); }
+				)
+			)
+				return &f;
+		}
+		return nullptr;
+	}
+
+private:
+	friend header_fields split_headers(std::string_view block, size_t *consumed);
+
+	std::vector<header_field> fields;
+	std::unique_ptr<char[]> arena;
+	size_t arena_size=0;
+};
+
+// Splits a header block made of "name: value" lines ending in CRLF (a bare
+// LF is also accepted), up to the first empty line.  Optional whitespace
+// around values is trimmed, and obsolete line folding is replaced by a
+// single space.  If consumed is not null, it receives the offset just past
+// the empty line, or the size of block if there is none.  A line without
+// ':', or a continuation line with no field before it, throws
+// std::invalid_argument.
+inline header_fields split_headers(std::string_view block, size_t *consumed=nullptr){
+	header_fields result;
+	const char *p=block.data(), *const last=p+block.size();
+	char *out=nullptr;
+	auto trim=[](const char *&a, const char *&b){
+		while(a!=b && detail::is_ows(*a))
+			++a;
+		while(b!=a && detail::is_ows(b[-1]))
+			--b;
+	};
+	while(p!=last){
+		// Names are short, so they are scanned a byte at a time and hashed on
+		// the way; the rest of the line is left to memchr().
+		const char *const line=p, *colon=nullptr;
+		const char *eol=p;
+		uint64_t name_hash=detail::fnv1a_basis;
+		for(; eol!=last && *eol!=':' && *eol!='\n'; ++eol)
+			name_hash=detail::fnv1a_lower(name_hash, *eol);
+		if(eol!=last && *eol==':'){
+			colon=eol;
+			eol=static_cast<const char *>(std::memchr(colon, '\n', last-colon));
+			if(!eol)
+				eol=last;
+		}
+		p=(eol==last? last: eol+1);
+		const char *end=eol;
+		if(end!=line && end[-1]=='\r')
+			--end;
+		if(end==line)
+			break;
+
+		if(detail::is_ows(*line)){
+			if(result.fields.empty())
+				throw std::invalid_argument("split_headers: continuation line without a header field");
+			const char *a=line, *b=end;
+			trim(a, b);
+			if(a==b)
+				continue;
+			if(!out){
+				// Unfolding never makes the block longer.
+				result.arena.reset(new char[block.size()]);
+				result.arena_size=block.size();
+				out=result.arena.get();
+			}
+			auto &value=result.fields.back().value;
+			if(value.data()+value.size()!=out){
+				std::memcpy(out, value.data(), value.size());
+				value=std::string_view(out, value.size());
+				out+=value.size();
+			}
+			if(!value.empty())
+				*out++=' ';
+			std::memcpy(out, a, b-a);
+			out+=b-a;
+			value=std::string_view(value.data(), out-value.data());
+		}
+		else {
+			if(!colon || colon>end)
+				throw std::invalid_argument("split_headers: header line without ':'");
+			std::string_view name(line, colon-line);
+			const char *a=colon+1, *b=end;
+			trim(a, b);
+			result.fields.push_back({name, std::string_view(a, b-a), name_hash});
+		}
+	}
+	if(consumed)
+		*consumed=p-block.data();
+	return result;
+}
+
+
+/****** Tokenizer that reports which separator ended each field. ******/
+struct token {
+	std::string_view field;
+	size_t sep_id;	// Index of the separator after field, or tokenizer::end_of_input.
+};
+
+// Splits on any of several separators and tells which one ended each
+// field, e.g. "a=b;c,d" with separators "=;," gives ("a", 0), ("b", 1),
+// ("c", 2) and ("d", end_of_input).  Candidate positions are found with a
+// vectorised scan for the separators' first characters; where several
+// separators match, the longest wins.  Empty fields are kept, except that
+// a separator at the very end of the input produces no empty last token.
+class tokenizer {
+public:
+	static constexpr size_t end_of_input=detail::npos;
+
+	class iterator {
+	public:
+		using iterator_category=std::forward_iterator_tag;
+		using value_type=token;
+		using difference_type=std::ptrdiff_t;
+		using pointer=const token *;
+		using reference=const token &;
+
+		iterator()=default;
+
+		reference operator*() const { return current; }
+		pointer operator->() const { return &current; }
+
+		iterator &operator++(){
+			advance();
+			return *this;
+		}
+
+		iterator operator++(int){
+			iterator old=*this;
+			advance();
+			return old;
+		}
+
+		bool operator==(const iterator &other) const { return p==other.p; }
+		bool operator!=(const iterator &other) const { return p!=other.p; }
+
+	private:
+		friend class tokenizer;
+
+		iterator(const tokenizer *owner, const char *first, const char *end): t(owner), p(first), last(end) {
+			advance();
+		}
+
+		void advance(){
+			if(!p)
+				return;
+			if(p==last){
+				p=nullptr;
+				return;
+			}
+			const char *q=p;
+			size_t sep_len=0;
+			current.sep_id=end_of_input;
+			while((q=t->first_chars.find(q, last))!=last){
+				if((current.sep_id=t->match(q, last, sep_len))!=end_of_input)
+					break;
+				++q;
+			}
+			current.field=std::string_view(p, q-p);
+			p=q+sep_len;
+		}
+
+		const tokenizer *t=nullptr;
+		const char *p=nullptr, *last=nullptr;
+		token current{};
+	};
+
+	class range {
+	public:
+		iterator begin() const { return iterator(t, str.data(), str.data()+str.size()); }
+		iterator end() const { return iterator(); }
+
+	private:
+		friend class tokenizer;
+
+		range(const tokenizer *owner, std::string_view input): t(owner), str(input) { }
+
+		const tokenizer *t;
+		std::string_view str;
+	};
+
+	// Each character of chars is a separator; its id is its position.
+	explicit tokenizer(std::string_view chars): first_chars(chars) {
+		for(char c: chars)
+			seps.emplace_back(1, c);
+		init_order();
+	}
+
+	// Each string is a separator; its id is its position.  Empty strings
+	// throw std::invalid_argument.
+	explicit tokenizer(const std::vector<std::string_view> &strings):
+		first_chars(first_chars_of(strings))
+	{
+		for(auto s: strings){
+			if(s.empty())
+				throw std::invalid_argument("tokenizer: empty separator");
+			seps.emplace_back(s);
+		}
+		init_order();
+	}
+
+	// Tokens of str, produced lazily; str must outlive the range.
+	range tokens(std::string_view str) const { return range(this, str); }
+
+	std::vector<token> split(std::string_view str) const {
+		std::vector<token> result;
+		for(auto &t: tokens(str))
+			result.push_back(t);
+		return result;
+	}
+
+	size_t size() const { return seps.size(); }
+	std::string_view separator(size_t id) const { return seps[id]; }
+
+private:
+	static std::string first_chars_of(const std::vector<std::string_view> &strings){
+		std::string result;
+		for(auto s: strings)
+			if(!s.empty() && result.find(s[0])==result.npos)
+				result.push_back(s[0]);
+		return result;
+	}
+
+	void init_order(){
+		by_length.resize(seps.size());
+		std::iota(by_length.begin(), by_length.end(), size_t(0));
+		std::stable_sort(
+			by_length.begin(), by_length.end(),
+			[this](size_t a, size_t b){ return seps[a].size()>seps[b].size(); }
+		);
+	}
+
+	size_t match(const char *p, const char *last, size_t &len) const {
+		for(size_t id: by_length){
+			const std::string &s=seps[id];
+			if(size_t(last-p)>=s.size() && !std::memcmp(p, s.data(), s.size())){
+				len=s.size();
+				return id;
+			}
+		}
+		return end_of_input;
+	}
+
+	std::vector<std::string> seps;
+	std::vector<size_t> by_length;
+	detail::byte_set first_chars;
+};
+
+
+/****** Field type inference. ******/
+enum class field_type: unsigned char {
+	empty, integer, floating, boolean, timestamp, string
+};
+
+constexpr size_t n_field_types=6;
+
+namespace detail {
+
+inline bool is_digit(char c){
+	return static_cast<unsigned char>(c-'0')<10;
+}
+
+// True if every character of [p, last) is an ASCII digit, checking sixteen
+// characters at a time where SSE2 is available.
+inline bool all_digits(const char *p, const char *last){
+#if defined(__SSE2__)
+	const __m128i zero=_mm_set1_epi8('0'), nine=_mm_set1_epi8(9);
+	for(; last-p>=16; p+=16){
+		__m128i d=_mm_sub_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)), zero);
+		// d<=9 (unsigned) exactly when min(d, 9)==d.
+		if(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(d, nine), d))!=0xffff)
+			return false;
+	}
+#endif
+	for(; p!=last; ++p)
+		if(!is_digit(*p))
+			return false;
+	return true;
+}
+
+inline const char *skip_digits(const char *p, const char *last){
+	while(p!=last && is_digit(*p))
+		++p;
+	return p;
+}
+
+inline bool iequals_ascii(std::string_view a, std::string_view b){
+	return
+		a.size()==b.size() &&
+		std::equal(
+			a.begin(), a.end(), b.begin(),
+			[](char x, char y){ return ascii_lower(x)==ascii_lower(y); }
+		)
+	;
+}
+
+// Matches n digits at p, advancing p.
+inline bool take_digits(const char *&p, const char *last, size_t n){
+	if(size_t(last-p)<n || !all_digits(p, p+n))
+		return false;
+	p+=n;
+	return true;
+}
+
+// Matches n digits at p, advancing p, and stores their value, which must
+// lie between lo and hi.
+inline bool take_number(const char *&p, const char *last, size_t n, unsigned lo, unsigned hi, unsigned &value){
+	const char *const first=p;
+	if(!take_digits(p, last, n))
+		return false;
+	value=0;
+	for(const char *q=first; q!=p; ++q)
+		value=value*10+unsigned(*q-'0');
+	return value>=lo && value<=hi;
+}
+
+inline unsigned days_in_month(unsigned year, unsigned month){
+	static constexpr unsigned char days[]={31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+	const bool leap=(year%4==0 && (year%100!=0 || year%400==0));
+	return days[month-1]+(month==2 && leap);
+}
+
+// YYYY-MM-DD, optionally followed by 'T' or ' ' and HH:MM[:SS[.frac]],
+// and then by 'Z' or a [+-]HH[:]MM offset.  The date must exist in the
+// proleptic Gregorian calendar; hours go up to 23, minutes up to 59 and
+// seconds up to 60, for leap seconds.
+inline bool is_timestamp(const char *p, const char *last){
+	unsigned year, month, day, n;
+	if(
+		!take_number(p, last, 4, 0, 9999, year) || p==last || *p++!='-' ||
+		!take_number(p, last, 2, 1, 12, month) || p==last || *p++!='-' ||
+		!take_number(p, last, 2, 1, days_in_month(year, month), day)
+	)
+		return false;
+	if(p==last)
+		return true;
+	if(*p!='T' && *p!=' ')
+		return false;
+	++p;
+	if(
+		!take_number(p, last, 2, 0, 23, n) || p==last || *p++!=':' ||
+		!take_number(p, last, 2, 0, 59, n)
+	)
+		return false;
+	if(p!=last && *p==':'){
+		++p;
+		if(!take_number(p, last, 2, 0, 60, n))
+			return false;
+		if(p!=last && *p=='.'){
+			const char *q=skip_digits(++p, last);
+			if(q==p)
+				return false;
+			p=q;
+		}
+	}
+	if(p!=last && *p=='Z')
+		++p;
+	else if(p!=last && (*p=='+' || *p=='-')){
+		++p;
+		if(!take_number(p, last, 2, 0, 23, n))
+			return false;
+		if(p!=last && *p==':')
+			++p;
+		if(!take_number(p, last, 2, 0, 59, n))
+			return false;
+	}
+	return p==last;
+}
+
+}	// namespace detail
+
+// Lexical type of one field, decided without converting it.
+inline field_type classify_field(std::string_view field){
+	const char *p=field.data(), *const last=p+field.size();
+	if(p==last)
+		return field_type::empty;
+	if(detail::all_digits(p, last))
+		return field_type::integer;
+	if(detail::iequals_ascii(field, "true") || detail::iequals_ascii(field, "false"))
+		return field_type::boolean;
+	if(detail::is_digit(*p) && last-p>=10 && p[4]=='-')
+		return detail::is_timestamp(p, last)? field_type::timestamp: field_type::string;
+
+	if(*p=='+' || *p=='-')
+		++p;
+	const char *q=detail::skip_digits(p, last);
+	size_t n_digits=q-p;
+	if(q==last)
+		return n_digits? field_type::integer: field_type::string;
+	if(*q=='.'){
+		const char *r=detail::skip_digits(++q, last);
+		n_digits+=r-q;
+		q=r;
+	}
+	if(!n_digits)
+		return field_type::string;
+	if(q!=last && (*q=='e' || *q=='E')){
+		if(++q!=last && (*q=='+' || *q=='-'))
+			++q;
+		const char *r=detail::skip_digits(q, last);
+		if(r==q)
+			return field_type::string;
+		q=r;
+	}
+	return q==last? field_type::floating: field_type::string;
+}
+
+// Votes cast by the fields of one column.
+struct type_votes {
+	size_t counts[n_field_types]{};
+
+	size_t operator[](field_type t) const { return counts[size_t(t)]; }
+
+	// Narrowest type that all non-empty fields fit: integers widen to
+	// floating; any other mix is a string.
+	field_type guess() const {
+		const size_t total=
+			std::accumulate(std::begin(counts), std::end(counts), size_t(0))-
+			(*this)[field_type::empty]
+		;
+		if(!total)
+			return field_type::empty;
+		for(auto t: {field_type::integer, field_type::boolean, field_type::timestamp})
+			if((*this)[t]==total)
+				return t;
+		if((*this)[field_type::integer]+(*this)[field_type::floating]==total)
+			return field_type::floating;
+		return field_type::string;
+	}
+};
+
+// Result of infer_types().  types holds the type of every field, record
+// after record; the fields of record n start at types[record_starts[n]].
+struct type_inference {
+	std::vector<field_type> types;
+	std::vector<size_t> record_starts;
+	std::vector<type_votes> columns;
+
+	std::vector<field_type> schema() const {
+		std::vector<field_type> result;
+		result.reserve(columns.size());
+		for(auto &c: columns)
+			result.push_back(c.guess());
+		return result;
+	}
+};
+
+// Classifies every field of buffer, which holds records separated by
+// record_sep (a trailing one is optional) with fields separated by
+// field_sep, and counts the votes of each column.  No field is copied.
+inline type_inference infer_types(std::string_view buffer, char record_sep, char field_sep){
+	const char seps[]={record_sep, field_sep};
+	const detail::byte_set delims(std::string_view(seps, 2));
+	type_inference result;
+	const char *p=buffer.data(), *const last=p+buffer.size();
+	size_t column=0;
+	while(p!=last){
+		if(!column)
+			result.record_starts.push_back(result.types.size());
+		const char *end=delims.find(p, last);
+		const field_type t=classify_field(std::string_view(p, end-p));
+		result.types.push_back(t);
+		if(column>=result.columns.size())
+			result.columns.resize(column+1);
+		++result.columns[column].counts[size_t(t)];
+		column=(end!=last && *end==field_sep)? column+1: 0;
+		p=(end==last? last: end+1);
+		if(p==last && column){
+			// A field separator at the very end leaves an empty last field.
+			result.types.push_back(field_type::empty);
+			if(column>=result.columns.size())
+				result.columns.resize(column+1);
+			++result.columns[column].counts[size_t(field_type::empty)];
+		}
+	}
+	return result;
+}
+
+
+/****** Batch parsing of numeric fields. ******/
+// Values converted by parse_integers() or parse_floats(), one per field.
+// errors[n] is nonzero if field n was not a valid number in range, in which
+// case values[n] is zero.
+template<class value_t>
+struct parsed_fields {
+	std::vector<value_t> values;
+	std::vector<unsigned char> errors;
+	size_t n_errors=0;
+};
+
+namespace detail {
+
+// from_chars() takes only '-'; a leading '+' is also accepted here, as it
+// is by parse_float().
+template<class int_t>
+inline bool parse_integer(std::string_view field, int_t &value){
+	const char *p=field.data(), *const last=p+field.size();
+	if(p!=last && *p=='+' && ++p!=last && *p=='-')
+		return false;
+	auto [end, ec]=std::from_chars(p, last, value);
+	return ec==std::errc() && end==last;
+}
+
+template<class float_t> struct float_fast_path;
+
+template<> struct float_fast_path<float> {
+	static constexpr int max_exponent=10;
+	static constexpr float pow10[]={1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f};
+};
+
+template<> struct float_fast_path<double> {
+	static constexpr int max_exponent=22;
+	static constexpr double pow10[]={
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+};
+
+// Clinger's fast path, as used by fast_float: when the decimal significand
+// and the power of ten are both exactly representable, one multiplication
+// or division gives the correctly rounded value.  Everything else goes to
+// std::from_chars().
+template<class float_t>
+inline bool parse_float(std::string_view field, float_t &value){
+	const char *p=field.data(), *const last=p+field.size();
+	const char *const start=p;
+	bool negative=false;
+	if(p!=last && (*p=='-' || *p=='+')){
+		negative=(*p=='-');
+		++p;
+	}
+	uint64_t mantissa=0;
+	int exponent=0, n_digits=0, n_significant=0;
+	for(; p!=last && is_digit(*p); ++p, ++n_digits)
+		if(mantissa || *p!='0'){
+			mantissa=mantissa*10+(*p-'0');
+			++n_significant;
+		}
+	if(p!=last && *p=='.'){
+		for(++p; p!=last && is_digit(*p); ++p, ++n_digits){
+			--exponent;
+			if(mantissa || *p!='0'){
+				mantissa=mantissa*10+(*p-'0');
+				++n_significant;
+			}
+		}
+	}
+	bool fast=(n_digits>0 && n_significant<=19);
+	if(n_digits && p!=last && (*p=='e' || *p=='E')){
+		const char *q=p+1;
+		bool exp_negative=false;
+		if(q!=last && (*q=='-' || *q=='+'))
+			exp_negative=(*q++=='-');
+		int e=0;
+		const char *r=q;
+		for(; r!=last && is_digit(*r); ++r)
+			if(e<100000)
+				e=e*10+(*r-'0');
+		if(r==q)
+			return false;
+		exponent+=exp_negative? -e: e;
+		p=r;
+	}
+	if(!n_digits){
+		// Only "inf", "infinity" and "nan", in any case, may lack digits;
+		// from_chars() decides.
+		if(p==last || (*p!='i' && *p!='I' && *p!='n' && *p!='N'))
+			return false;
+		fast=false;
+	}
+	else if(p!=last)
+		return false;
+	using fp=float_fast_path<float_t>;
+	if(
+		fast && mantissa<=(uint64_t(1)<<std::numeric_limits<float_t>::digits) &&
+		exponent>=-fp::max_exponent && exponent<=fp::max_exponent
+	){
+		float_t v=static_cast<float_t>(mantissa);
+		v=(exponent<0? v/fp::pow10[-exponent]: v*fp::pow10[exponent]);
+		value=negative? -v: v;
+		return true;
+	}
+	// from_chars() does not accept '+'.
+	const char *first=(*start=='+'? start+1: start);
+	auto [end, ec]=std::from_chars(first, last, value);
+	return ec==std::errc() && end==last;
+}
+
+template<class value_t, class field_range_t, class parse_t>
+inline parsed_fields<value_t> parse_fields(const field_range_t &fields, parse_t parse){
+	parsed_fields<value_t> result;
+	const size_t n=std::distance(std::begin(fields), std::end(fields));
+	result.values.resize(n);
+	result.errors.resize(n);
+	value_t *out=result.values.data();
+	unsigned char *err=result.errors.data();
+	for(const auto &field: fields){
+		if(!parse(std::string_view(field), *out)){
+			*out=value_t();
+			*err=1;
+			++result.n_errors;
+		}
+		++out;
+		++err;
+	}
+	return result;
+}
+
+}	// namespace detail
+
+// Converts every field of a range (of std::string_view, std::string or
+// anything else convertible to std::string_view) to int_t with
+// from_chars(), plus an optional leading '+'.
+template<class int_t, class field_range_t>
+inline parsed_fields<int_t> parse_integers(const field_range_t &fields){
+	static_assert(std::is_integral_v<int_t>, "parse_integers() needs an integral type");
+	return
+		detail::parse_fields<int_t>(
+			fields,
+			[](std::string_view f, int_t &v){ return detail::parse_integer(f, v); }
+		)
+	;
+}
+
+// Converts every field of a range to float or double.  Infinities and NaNs
+// are accepted in the spellings from_chars() understands ("inf", "nan",
+// "infinity", with an optional sign).
+template<class float_t, class field_range_t>
+inline parsed_fields<float_t> parse_floats(const field_range_t &fields){
+	static_assert(
+		std::is_same_v<float_t, float> || std::is_same_v<float_t, double>,
+		"parse_floats() needs float or double"
+	);
+	return
+		detail::parse_fields<float_t>(
+			fields,
+			[](std::string_view f, float_t &v){ return detail::parse_float(f, v); }
+		)
+	;
+}
+
+
+/****** Reusable splitter objects. ******/
+// Splits many strings on the same separator, with the same semantics as
+// split().  Field counts and lengths are usually stable from one call to
+// the next, so the splitter keeps exponential moving averages of them, as
+// seen by the field sink, and reserves the result vector (and, for
+// packed(), the character buffer) from those before scanning.
+template<class char_t, class out_ch_alloc_t=std::allocator<char_t>>
+class basic_splitter {
+	static_assert(
+		detail::uses_split_core<char_t, std::char_traits<char_t>>,
+		"basic_splitter needs a standard character type"
+	);
+
+public:
+	using string_type=std::basic_string<char_t, std::char_traits<char_t>, out_ch_alloc_t>;
+	using view_type=std::basic_string_view<char_t>;
+
+	struct statistics {
+		size_t calls=0;
+		double fields=0;		// Moving average of fields per call.
+		double field_chars=0;	// Moving average of characters in all fields.
+	};
+
+	// weight, the share of each new call in the averages, must be in (0, 1].
+	explicit basic_splitter(
+		char_t separator, size_t field_limit=0, double weight=0.125,
+		const out_ch_alloc_t &allocator=out_ch_alloc_t()
+	):
+		basic_splitter(view_type(&separator, 1), field_limit, weight, allocator)
+	{ }
+
+	explicit basic_splitter(
+		view_type separator, size_t field_limit=0, double weight=0.125,
+		const out_ch_alloc_t &allocator=out_ch_alloc_t()
+	):
+		sep(separator, allocator), max_fields(field_limit), smoothing(weight),
+		alloc_ch(allocator), arena(allocator)
+	{
+		if(!(weight>0 && weight<=1))
+			throw std::invalid_argument("basic_splitter: smoothing must be in (0, 1]");
+	}
+
+	std::vector<string_type> operator()(view_type str){
+		std::vector<string_type> result;
+		detail::field_collector<decltype(result), char_t, out_ch_alloc_t> out{result, str.data(), alloc_ch};
+		run(str, result, out.sink, &out);
+		return result;
+	}
+
+	// Like operator(), but the fields are views into str.
+	std::vector<view_type> views(view_type str){
+		std::vector<view_type> result;
+		std::pair<std::vector<view_type> *, const char_t *> out{&result, str.data()};
+		run(
+			str, result,
+			[](void *ctx, size_t pos, size_t len){
+				auto &o=*static_cast<decltype(out) *>(ctx);
+				o.first->emplace_back(o.second+pos, len);
+			},
+			&out
+		);
+		return result;
+	}
+
+	// Like views(), but the fields are copied back to back into a buffer
+	// owned by the splitter, so str need not outlive them.  They stay valid
+	// until the next call of packed().
+	std::vector<view_type> packed(view_type str){
+		std::vector<view_type> result;
+		arena.clear();
+		if(stat.calls)
+			arena.reserve(static_cast<size_t>(stat.field_chars+0.5));
+		struct packer {
+			string_type &arena;
+			std::vector<view_type> &result;
+			const char_t *str;
+
+			static void sink(void *ctx, size_t pos, size_t len){
+				auto &self=*static_cast<packer *>(ctx);
+				self.arena.append(self.str+pos, len);
+				self.result.emplace_back(self.str+pos, len);
+			}
+		} out{arena, result, str.data()};
+		run(str, result, out.sink, &out);
+		// The arena may have moved while growing, so the views are only laid
+		// over it at the end.
+		const char_t *p=arena.data();
+		for(auto &f: result){
+			f=view_type(p, f.size());
+			p+=f.size();
+		}
+		return result;
+	}
+
+	const statistics &stats() const { return stat; }
+	void reset_stats(){ stat=statistics(); }
+
+private:
+	// Forwards to the real sink, counting fields and characters on the way.
+	struct counting_sink {
+		detail::field_sink sink;
+		void *ctx;
+		size_t chars=0;
+
+		static void count(void *c, size_t pos, size_t len){
+			auto &me=*static_cast<counting_sink *>(c);
+			me.chars+=len;
+			me.sink(me.ctx, pos, len);
+		}
+	};
+
+	template<class result_t>
+	void run(view_type str, result_t &result, detail::field_sink sink, void *ctx){
+		if(stat.calls)
+			result.reserve(static_cast<size_t>(stat.fields+0.5)+1);
+		counting_sink counter{sink, ctx};
+		detail::split_core(
+			str.data(), str.size(), sep.data(), sep.size(), sizeof(char_t),
+			max_fields, counter.count, &counter
+		);
+		if(!stat.calls++){
+			stat.fields=result.size();
+			stat.field_chars=counter.chars;
+		}
+		else {
+			stat.fields+=smoothing*(result.size()-stat.fields);
+			stat.field_chars+=smoothing*(counter.chars-stat.field_chars);
+		}
+	}
+
+	string_type sep;
+	size_t max_fields;
+	double smoothing;
+	out_ch_alloc_t alloc_ch;
+	string_type arena;
+	statistics stat;
+};
+
+using splitter=basic_splitter<char>;
+using wsplitter=basic_splitter<wchar_t>;
+
+
+/****** Memory footprint of split results. ******/
+// Heap memory held by one or more split results.  Footprints add up with
+// operator+=, so a cache can keep one running total for all its entries.
+struct memory_footprint {
+	size_t results=0;			// Number of results accounted for.
+	size_t elements=0;			// Fields (or values) in use.
+	size_t vector_capacity=0;	// Element slots allocated.
+	size_t vector_bytes=0;		// Bytes of those slots.
+	size_t heap_strings=0;		// Owned strings with a heap buffer.
+	size_t inline_strings=0;	// Owned strings stored inline (SSO).
+	size_t string_heap_bytes=0;	// Bytes of the strings' heap buffers.
+	size_t arena_bytes=0;		// Bytes of decoding arenas.
+	size_t wasted_bytes=0;		// Allocated but unused bytes.
+
+	size_t heap_bytes() const { return vector_bytes+string_heap_bytes+arena_bytes; }
+
+	memory_footprint &operator+=(const memory_footprint &other){
+		results+=other.results;
+		elements+=other.elements;
+		vector_capacity+=other.vector_capacity;
+		vector_bytes+=other.vector_bytes;
+		heap_strings+=other.heap_strings;
+		inline_strings+=other.inline_strings;
+		string_heap_bytes+=other.string_heap_bytes;
+		arena_bytes+=other.arena_bytes;
+		wasted_bytes+=other.wasted_bytes;
+		return *this;
+	}
+};
+
+namespace detail {
+
+template<class elem_t, class alloc_t>
+inline void add_vector_usage(memory_footprint &mf, const std::vector<elem_t, alloc_t> &v){
+	mf.elements+=v.size();
+	mf.vector_capacity+=v.capacity();
+	mf.vector_bytes+=v.capacity()*sizeof(elem_t);
+	mf.wasted_bytes+=(v.capacity()-v.size())*sizeof(elem_t);
+}
+
+template<class str_t>
+inline void add_string_usage(memory_footprint &, const str_t &){ }
+
+template<class char_t, class char_traits_t, class alloc_t>
+inline void add_string_usage(
+	memory_footprint &mf, const std::basic_string<char_t, char_traits_t, alloc_t> &s
 ){
-	return
-		split(
-			str,
-			std::basic_string_view<char_t, char_traits_t>(sep), max_fields,
-			alloc_ch, alloc_str
-		)
-	;
+	// A string whose characters lie inside the string object itself uses
+	// the small string optimisation and owns no heap buffer.
+	auto data=reinterpret_cast<const unsigned char *>(s.data());
+	auto self=reinterpret_cast<const unsigned char *>(&s);
+	if(data>=self && data<self+sizeof s)
+		++mf.inline_strings;
+	else {
+		++mf.heap_strings;
+		mf.string_heap_bytes+=(s.capacity()+1)*sizeof(char_t);
+		mf.wasted_bytes+=(s.capacity()-s.size())*sizeof(char_t);
+	}
+}
+
+}	// namespace detail
+
+// Footprint of a vector returned by split(), or of a vector of views.
+template<class elem_t, class alloc_t>
+inline memory_footprint memory_usage(const std::vector<elem_t, alloc_t> &result){
+	memory_footprint mf;
+	mf.results=1;
+	detail::add_vector_usage(mf, result);
+	for(auto &e: result)
+		detail::add_string_usage(mf, e);
+	return mf;
+}
+
+inline memory_footprint memory_usage(const query_params &result){
+	memory_footprint mf;
+	mf.results=1;
+	mf.elements=result.size();
+	mf.vector_capacity=result.capacity();
+	mf.vector_bytes=result.capacity()*sizeof(query_param);
+	mf.arena_bytes=result.arena_capacity();
+	mf.wasted_bytes=(result.capacity()-result.size())*sizeof(query_param);
+	return mf;
+}
+
+inline memory_footprint memory_usage(const header_fields &result){
+	memory_footprint mf;
+	mf.results=1;
+	mf.elements=result.size();
+	mf.vector_capacity=result.capacity();
+	mf.vector_bytes=result.capacity()*sizeof(header_field);
+	mf.arena_bytes=result.arena_capacity();
+	mf.wasted_bytes=(result.capacity()-result.size())*sizeof(header_field);
+	return mf;
 }
 
+template<class value_t>
+inline memory_footprint memory_usage(const parsed_fields<value_t> &result){
+	memory_footprint mf;
+	mf.results=1;
+	detail::add_vector_usage(mf, result.values);
+	detail::add_vector_usage(mf, result.errors);
+	mf.elements=result.values.size();
+	return mf;
+}
 
+inline memory_footprint memory_usage(const type_inference &result){
+	memory_footprint mf;
+	mf.results=1;
+	detail::add_vector_usage(mf, result.types);
+	detail::add_vector_usage(mf, result.record_starts);
+	detail::add_vector_usage(mf, result.columns);
+	mf.elements=result.types.size();
+	return mf;
+}
 
 
 /****** Functions that join split things into a bigger string. ******/
+namespace detail {
+
+template<class T>
+struct is_string_like: std::false_type { };
+
+template<class T>
+constexpr bool is_char_type=
+	std::is_same_v<T, char> || std::is_same_v<T, signed char> ||
+	std::is_same_v<T, unsigned char> || std::is_same_v<T, wchar_t> ||
+#if __cplusplus >= 202002L
+	std::is_same_v<T, char8_t> ||
+#endif
+	std::is_same_v<T, char16_t> || std::is_same_v<T, char32_t>
+;
+
+template<class char_t, class char_traits_t, class alloc_t>
+struct is_string_like<std::basic_string<char_t, char_traits_t, alloc_t>>: std::true_type { };
+
+template<class char_t, class char_traits_t>
+struct is_string_like<std::basic_string_view<char_t, char_traits_t>>: std::true_type { };
+
+template<class char_t, class T>
+constexpr bool is_string_of=false;
+
+template<class char_t, class char_traits_t, class alloc_t>
+constexpr bool is_string_of<char_t, std::basic_string<char_t, char_traits_t, alloc_t>> =true;
+
+template<class char_t, class char_traits_t>
+constexpr bool is_string_of<char_t, std::basic_string_view<char_t, char_traits_t>> =true;
+
+// Joiners that are text of char_t: one character, a pointer to a
+// null-terminated string, or a string or view.
+template<class char_t, class T>
+constexpr bool is_text_of=
+	std::is_same_v<T, char_t> ||
+	std::is_convertible_v<const T &, const char_t *> ||
+	is_string_of<char_t, T>
+;
+
+template<class char_t, class T>
+inline std::basic_string_view<char_t> text_view(const T &text){
+	if constexpr(std::is_same_v<T, char_t>)
+		return std::basic_string_view<char_t>(&text, 1);
+	else if constexpr(std::is_convertible_v<const T &, const char_t *>)
+		return std::basic_string_view<char_t>(static_cast<const char_t *>(text));
+	else
+		return std::basic_string_view<char_t>(text.data(), text.size());
+}
+
+// Copies n bytes with fixed-width moves, which compilers turn into single
+// loads and stores: two that overlap cover any n from 4 to 16, and 16-byte
+// blocks, the last one overlapping, up to 64.  For the short strings that
+// dominate many joins, that avoids the dispatch of a variable-length
+// memcpy() call.
+inline void copy_short(void *dst, const void *src, size_t n){
+	auto d=static_cast<unsigned char *>(dst);
+	auto s=static_cast<const unsigned char *>(src);
+	if(n>=16){
+		if(n>64){
+			std::memcpy(d, s, n);
+			return;
+		}
+		for(size_t i=0; i+16<n; i+=16)
+			std::memcpy(d+i, s+i, 16);
+		std::memcpy(d+n-16, s+n-16, 16);
+	}
+	else if(n>=8){
+		std::memcpy(d, s, 8);
+		std::memcpy(d+n-8, s+n-8, 8);
+	}
+	else if(n>=4){
+		std::memcpy(d, s, 4);
+		std::memcpy(d+n-4, s+n-4, 4);
+	}
+	else if(n){
+		d[0]=s[0];
+		d[n/2]=s[n/2];
+		d[n-1]=s[n-1];
+	}
+}
+
+// basic_join() of strings: sizes the result in a first pass over the
+// elements, then copies them and the joiners into it with copy_short().
+template<class char_t, class char_traits_t, class out_ch_alloc_t, class iter_t>
+inline std::basic_string<char_t, char_traits_t, out_ch_alloc_t> join_strings(
+	iter_t first, iter_t last,
+	std::basic_string_view<char_t> joiner, std::basic_string_view<char_t> last_joiner,
+	const out_ch_alloc_t &alloc_ch
+){
+	std::basic_string<char_t, char_traits_t, out_ch_alloc_t> result(alloc_ch);
+	size_t n=0, chars=0;
+	for(auto it=first; it!=last; ++it){
+		++n;
+		chars+=(*it).size();
+	}
+	if(!n)
+		return result;
+	if(n>1)
+		chars+=(n-2)*joiner.size()+last_joiner.size();
+	result.resize(chars);
+	char_t *out=&result[0];
+	for(size_t i=0; first!=last; ++first, ++i){
+		if(i){
+			const auto &j=(i+1==n? last_joiner: joiner);
+			copy_short(out, j.data(), j.size()*sizeof(char_t));
+			out+=j.size();
+		}
+		const auto &elem=*first;
+		copy_short(out, elem.data(), elem.size()*sizeof(char_t));
+		out+=elem.size();
+	}
+	return result;
+}
+
+}	// namespace detail
+
 template<
 	class char_t, class char_traits_t=std::char_traits<char_t>,
 	class out_ch_alloc_t=std::allocator<char_t>,
 	class input_iter_t,
 	class joiner_t, class last_joiner_t
 >
-inline std::basic_string<char_t, char_traits_t, out_ch_alloc_t>
+ORG_PPIRES_SPLIT_INLINE std::basic_string<char_t, char_traits_t, out_ch_alloc_t>
 basic_join(
 	input_iter_t first, input_iter_t last,
 	const joiner_t &joiner, const last_joiner_t &last_joiner,
 	const std::locale &out_locale=std::locale(),
 	const out_ch_alloc_t alloc_ch=out_ch_alloc_t()
 ){
-	std::basic_ostringstream<char_t, char_traits_t, out_ch_alloc_t>
-		output{
-			std::basic_string<char_t, char_traits_t, out_ch_alloc_t>(alloc_ch)
-		}
-	;
-	output.imbue(out_locale);
-	if(first!=last){
-		output << *first;
-		if(++first!=last){
-			auto second=first;
-			while(++second!=last)
-				output << joiner << *first++;
-			output << last_joiner << *first;
+	// Strings come out of a stream unchanged, whatever its locale, so a
+	// forward range of them is copied directly.
+	using elem_t=typename std::iterator_traits<input_iter_t>::value_type;
+	if constexpr(
+		detail::is_string_of<char_t, elem_t> &&
+		detail::is_text_of<char_t, joiner_t> && detail::is_text_of<char_t, last_joiner_t> &&
+		std::is_base_of_v<
+			std::forward_iterator_tag,
+			typename std::iterator_traits<input_iter_t>::iterator_category
+		>
+	)
+		return
+			detail::join_strings<char_t, char_traits_t>(
+				first, last,
+				detail::text_view<char_t>(joiner), detail::text_view<char_t>(last_joiner),
+				alloc_ch
+			)
+		;
+	else {
+		std::basic_ostringstream<char_t, char_traits_t, out_ch_alloc_t>
+			output{
+				std::basic_string<char_t, char_traits_t, out_ch_alloc_t>(alloc_ch)
+			}
+		;
+		output.imbue(out_locale);
+		if(first!=last){
+			output << *first;
+			if(++first!=last){
+				auto second=first;
+				while(++second!=last)
+					output << joiner << *first++;
+				output << last_joiner << *first;
+			}
 		}
+		return output.str();
 	}
-	return output.str();
 }
 
 template<
@@ -1071,7 +2630,684 @@ join(
 	;
 }
 
+
+/****** Incremental join. ******/
+namespace detail {
+
+// Appends one element to buf as basic_join() would insert it into a stream
+// with the classic locale, but without going through a stream for
+// characters, strings and arithmetic values; floating point is formatted
+// with std::to_chars() into a stack buffer.  Other types use fallback.
+template<class char_t, class char_traits_t, class alloc_t, class elem_t>
+inline void append_element(
+	std::basic_string<char_t, char_traits_t, alloc_t> &buf, const elem_t &elem,
+	std::basic_ostringstream<char_t, char_traits_t> &fallback
+){
+	if constexpr(is_string_like<elem_t>::value)
+		buf.append(elem.data(), elem.size());
+	else if constexpr(std::is_same_v<elem_t, char_t>)
+		buf.push_back(elem);
+	else if constexpr(std::is_same_v<std::decay_t<elem_t>, const char_t *> || std::is_same_v<std::decay_t<elem_t>, char_t *>)
+		buf.append(elem);
+	else if constexpr(std::is_same_v<elem_t, bool>)
+		buf.push_back(char_t(elem? '1': '0'));
+	else if constexpr(std::is_integral_v<elem_t> && !is_char_type<elem_t>){
+		char digits[std::numeric_limits<elem_t>::digits10+3];
+		auto end=std::to_chars(digits, digits+sizeof digits, elem).ptr;
+		buf.append(digits, end);
+	}
+	else if constexpr(std::is_floating_point_v<elem_t>){
+		// The stream default: %g with six significant digits.
+		char digits[32];
+		auto end=std::to_chars(digits, digits+sizeof digits, elem, std::chars_format::general, 6).ptr;
+		buf.append(digits, end);
+	}
+	else {
+		fallback.str(std::basic_string<char_t, char_traits_t>());
+		fallback << elem;
+		const auto &s=fallback.str();
+		buf.append(s.data(), s.size());
+	}
+}
+
+}	// namespace detail
+
+// Builds one big joined string from elements added one at a time, with the
+// joiner/last_joiner rules of basic_join().  The buffer grows geometrically
+// and is reused.  If a destination is given, everything but the last
+// element is written out whenever the buffer reaches flush_threshold
+// characters; the last element stays until the next add() or finish(), in
+// case its joiner must become last_joiner.
+//
+// Unlike basic_join(), which takes a locale, elements are always formatted
+// as in the classic locale: numbers never get digit grouping or a native
+// decimal point, whatever the global locale is.  The writer is meant for
+// bulk machine-readable output; use basic_join() for localized text.
+//
+// A failed write throws from add() or finish(), and failed() stays true
+// afterwards.  The destructor finishes an unfinished writer but cannot
+// report errors, so call finish() to see them.  split_posix.h adds
+// writers to file descriptors.
+template<class char_t, class char_traits_t=std::char_traits<char_t>, class out_ch_alloc_t=std::allocator<char_t>>
+class basic_join_writer {
+public:
+	using string_type=std::basic_string<char_t, char_traits_t, out_ch_alloc_t>;
+	using view_type=std::basic_string_view<char_t, char_traits_t>;
+
+	basic_join_writer(
+		view_type joiner_text, view_type last_joiner_text,
+		const out_ch_alloc_t &alloc_ch=out_ch_alloc_t()
+	):
+		buf(alloc_ch), joiner(joiner_text, alloc_ch), last_joiner(last_joiner_text, alloc_ch)
+	{
+		fallback.imbue(std::locale::classic());
+	}
+
+	explicit basic_join_writer(view_type joiner_text, const out_ch_alloc_t &alloc_ch=out_ch_alloc_t()):
+		basic_join_writer(joiner_text, joiner_text, alloc_ch)
+	{ }
+
+	basic_join_writer(
+		view_type joiner_text, view_type last_joiner_text,
+		std::basic_ostream<char_t, char_traits_t> &os, size_t threshold=64*1024
+	):
+		basic_join_writer(joiner_text, last_joiner_text, write_ostream, &os, threshold)
+	{ }
+
+	basic_join_writer(
+		view_type joiner_text, view_type last_joiner_text,
+		FILE *fp, size_t threshold=64*1024
+	):
+		basic_join_writer(joiner_text, last_joiner_text, write_file, fp, threshold)
+	{ }
+
+	basic_join_writer(const basic_join_writer &)=delete;
+	basic_join_writer &operator=(const basic_join_writer &)=delete;
+
+	~basic_join_writer(){
+		if(dest && !finished && !write_failed){
+			try {
+				finish();
+			}
+			catch(...){
+				// Nowhere to report it; see the class comment.
+			}
+		}
+	}
+
+	template<class elem_t>
+	basic_join_writer &add(const elem_t &elem){
+		if(n_elems++){
+			last_sep=buf.size();
+			buf.append(joiner);
+		}
+		detail::append_element(buf, elem, fallback);
+		if(dest && buf.size()>=flush_threshold)
+			flush(n_elems>1? last_sep: buf.size());
+		return *this;
+	}
+
+	template<class elem_t>
+	basic_join_writer &operator<<(const elem_t &elem){ return add(elem); }
+
+	// Puts last_joiner before the last element and writes out whatever is
+	// left.  No element may be added afterwards.
+	void finish(){
+		if(finished)
+			return;
+		finished=true;
+		if(n_elems>1 && last_joiner!=joiner)
+			buf.replace(last_sep, joiner.size(), last_joiner);
+		if(dest)
+			flush(buf.size());
+	}
+
+	size_t size() const { return n_elems; }
+	size_t bytes_written() const { return written; }
+	bool failed() const { return write_failed; }
+
+	// Joined text not yet written out (all of it, without a destination).
+	view_type view() const { return buf; }
+	string_type str(){
+		finish();
+		return buf;
+	}
+
+protected:
+	// Writes n characters at data to d, throwing on failure.
+	using write_fn=void (*)(void *d, const char_t *data, size_t n);
+
+	basic_join_writer(
+		view_type joiner_text, view_type last_joiner_text,
+		write_fn fn, void *d, size_t threshold
+	):
+		basic_join_writer(joiner_text, last_joiner_text)
+	{
+		write=fn;
+		dest=d;
+		flush_threshold=threshold;
+		buf.reserve(threshold+threshold/2);
+	}
+
+private:
+	void flush(size_t n){
+		if(!n)
+			return;
+		try {
+			write(dest, buf.data(), n);
+		}
+		catch(...){
+			write_failed=true;
+			throw;
+		}
+		written+=n;
+		buf.erase(0, n);
+		last_sep=0;
+	}
+
+	static void write_ostream(void *d, const char_t *data, size_t n){
+		if(!static_cast<std::basic_ostream<char_t, char_traits_t> *>(d)->write(data, n))
+			throw std::ios_base::failure("join_writer: stream write failed");
+	}
+
+	static void write_file(void *d, const char_t *data, size_t n){
+		if(std::fwrite(data, sizeof(char_t), n, static_cast<FILE *>(d))!=n)
+			throw std::system_error(errno, std::generic_category(), "join_writer: fwrite");
+	}
+
+	string_type buf;
+	string_type joiner, last_joiner;
+	std::basic_ostringstream<char_t, char_traits_t> fallback;
+	size_t n_elems=0, last_sep=0, written=0;
+	bool finished=false, write_failed=false;
+	write_fn write=nullptr;
+	void *dest=nullptr;
+	size_t flush_threshold=split_max;
+};
+
+using join_writer=basic_join_writer<char>;
+using wjoin_writer=basic_join_writer<wchar_t>;
+
+
+/****** Joining associative containers. ******/
+namespace detail {
+
+// Formats an arithmetic value with std::to_chars() (shortest round-trip
+// form for floating point) and passes the characters to fn.
+template<class value_t, class fn_t>
+inline void with_number_chars(const value_t &v, fn_t fn){
+	char digits[128];
+	auto end=std::to_chars(digits, digits+sizeof digits, v).ptr;
+	fn(digits, size_t(end-digits));
+}
+
+// Length and writing of one key or value for join_kv().
+template<class char_t, class value_t>
+inline size_t kv_length(const value_t &v){
+	if constexpr(is_string_like<value_t>::value)
+		return v.size();
+	else if constexpr(std::is_same_v<value_t, char_t> || std::is_same_v<value_t, bool>)
+		return 1;
+	else if constexpr(std::is_same_v<std::decay_t<value_t>, const char_t *> || std::is_same_v<std::decay_t<value_t>, char_t *>)
+		return std::char_traits<char_t>::length(v);
+	else {
+		static_assert(std::is_arithmetic_v<value_t>, "join_kv() needs string-like or arithmetic keys and values");
+		size_t len;
+		with_number_chars(v, [&len](const char *, size_t n){ len=n; });
+		return len;
+	}
+}
+
+template<class char_t, class value_t>
+inline char_t *kv_write(char_t *out, const value_t &v){
+	if constexpr(is_string_like<value_t>::value)
+		return std::copy(v.data(), v.data()+v.size(), out);
+	else if constexpr(std::is_same_v<value_t, char_t>){
+		*out=v;
+		return out+1;
+	}
+	else if constexpr(std::is_same_v<value_t, bool>){
+		*out=char_t(v? '1': '0');
+		return out+1;
+	}
+	else if constexpr(std::is_same_v<std::decay_t<value_t>, const char_t *> || std::is_same_v<std::decay_t<value_t>, char_t *>)
+		return std::copy(v, v+std::char_traits<char_t>::length(v), out);
+	else {
+		with_number_chars(v, [&out](const char *p, size_t n){ out=std::copy(p, p+n, out); });
+		return out;
+	}
+}
+
+template<class char_t, class char_traits_t, class out_ch_alloc_t, class container_t>
+inline std::basic_string<char_t, char_traits_t, out_ch_alloc_t>
+join_kv(
+	const container_t &cont,
+	std::basic_string_view<char_t, char_traits_t> pair_sep,
+	std::basic_string_view<char_t, char_traits_t> kv_sep,
+	bool sort_keys, const out_ch_alloc_t &alloc_ch
+){
+	using elem_t=typename container_t::value_type;
+	std::vector<const elem_t *> order;
+	if(sort_keys){
+		for(auto &e: cont)
+			order.push_back(&e);
+		std::sort(
+			order.begin(), order.end(),
+			[](const elem_t *a, const elem_t *b){ return a->first<b->first; }
+		);
+	}
+	auto for_each=[&](auto fn){
+		if(sort_keys)
+			for(auto e: order)
+				fn(*e);
+		else
+			for(auto &e: cont)
+				fn(e);
+	};
+
+	size_t n=0, len=0;
+	for_each([&](const elem_t &e){
+		len+=kv_length<char_t>(e.first)+kv_length<char_t>(e.second);
+		++n;
+	});
+	std::basic_string<char_t, char_traits_t, out_ch_alloc_t> result(alloc_ch);
+	if(!n)
+		return result;
+	result.resize(len+n*kv_sep.size()+(n-1)*pair_sep.size());
+	char_t *out=&result[0];
+	bool first=true;
+	for_each([&](const elem_t &e){
+		if(!first)
+			out=std::copy(pair_sep.begin(), pair_sep.end(), out);
+		first=false;
+		out=kv_write(out, e.first);
+		out=std::copy(kv_sep.begin(), kv_sep.end(), out);
+		out=kv_write(out, e.second);
+	});
+	return result;
+}
+
+}	// namespace detail
+
+// Joins the key/value pairs of an associative container (or any range of
+// pairs) into "k1=v1;k2=v2", sizing the result exactly so that it is
+// allocated once.  Keys and values may be strings, characters or
+// arithmetic values, which are formatted with std::to_chars().  With
+// sort_keys, pairs are written in key order, e.g. for std::unordered_map.
+template<
+	class char_t=char, class char_traits_t=std::char_traits<char_t>,
+	class out_ch_alloc_t=std::allocator<char_t>,
+	class container_t
+>
+inline std::basic_string<char_t, char_traits_t, out_ch_alloc_t>
+join_kv(
+	const container_t &cont,
+	std::basic_string_view<char_t, char_traits_t> pair_sep,
+	std::basic_string_view<char_t, char_traits_t> kv_sep,
+	bool sort_keys=false,
+	const out_ch_alloc_t &alloc_ch=out_ch_alloc_t()
+){
+	return detail::join_kv(cont, pair_sep, kv_sep, sort_keys, alloc_ch);
+}
+
+template<
+	class char_t, class char_traits_t=std::char_traits<char_t>,
+	class out_ch_alloc_t=std::allocator<char_t>,
+	class container_t
+>
+inline std::basic_string<char_t, char_traits_t, out_ch_alloc_t>
+join_kv(
+	const container_t &cont,
+	const char_t *pair_sep, const char_t *kv_sep,
+	bool sort_keys=false,
+	const out_ch_alloc_t &alloc_ch=out_ch_alloc_t()
+){
+	return
+		detail::join_kv(
+			cont,
+			std::basic_string_view<char_t, char_traits_t>(pair_sep),
+			std::basic_string_view<char_t, char_traits_t>(kv_sep),
+			sort_keys, alloc_ch
+		)
+	;
+}
+
+template<
+	class char_t, class char_traits_t=std::char_traits<char_t>,
+	class out_ch_alloc_t=std::allocator<char_t>,
+	class container_t
+>
+inline std::basic_string<char_t, char_traits_t, out_ch_alloc_t>
+join_kv(
+	const container_t &cont,
+	char_t pair_sep, char_t kv_sep,
+	bool sort_keys=false,
+	const out_ch_alloc_t &alloc_ch=out_ch_alloc_t()
+){
+	return
+		detail::join_kv(
+			cont,
+			std::basic_string_view<char_t, char_traits_t>(&pair_sep, 1),
+			std::basic_string_view<char_t, char_traits_t>(&kv_sep, 1),
+			sort_keys, alloc_ch
+		)
+	;
+}
+
+
+/****** Projection of selected fields into new records. ******/
+namespace detail {
+
+// Fields 0 to n_fields-1 of record, empty where the record is shorter.
+// Fields after the last one needed are not scanned.
+inline void locate_fields(
+	std::string_view record, const byte_set &sep, size_t n_fields,
+	std::vector<std::string_view> &fields
+){
+	fields.clear();
+	const char *p=record.data(), *const last=p+record.size();
+	while(fields.size()<n_fields){
+		const char *end=sep.find(p, last);
+		fields.emplace_back(p, end-p);
+		if(end==last)
+			break;
+		p=end+1;
+	}
+	fields.resize(n_fields);
+}
+
+inline size_t projection_size(
+	const std::vector<std::string_view> &fields, const std::vector<size_t> &columns,
+	std::string_view out_sep
+){
+	size_t size=(columns.size()-1)*out_sep.size();
+	for(size_t c: columns)
+		size+=fields[c].size();
+	return size;
+}
+
+inline char *write_projection(
+	char *out, const std::vector<std::string_view> &fields, const std::vector<size_t> &columns,
+	std::string_view out_sep
+){
+	for(size_t i=0; i<columns.size(); ++i){
+		if(i){
+			copy_short(out, out_sep.data(), out_sep.size());
+			out+=out_sep.size();
+		}
+		const auto &f=fields[columns[i]];
+		copy_short(out, f.data(), f.size());
+		out+=f.size();
+	}
+	return out;
+}
+
+inline void append_projection(
+	std::string &out, const std::vector<std::string_view> &fields, const std::vector<size_t> &columns,
+	std::string_view out_sep
+){
+	for(size_t i=0; i<columns.size(); ++i){
+		if(i)
+			out.append(out_sep);
+		out.append(fields[columns[i]]);
+	}
+}
+
+}	// namespace detail
+
+// Joins, with out_sep, the fields of record (separated by in_sep) whose
+// indices, counted from zero, are in columns, in that order; cut -f with
+// separator translation.  Fields missing from record come out empty.  Only
+// the selected bytes are copied, into a result of the exact size.  An
+// empty columns throws std::invalid_argument, as in project_join_records().
+inline std::string project_join(
+	std::string_view record, char in_sep, const std::vector<size_t> &columns,
+	std::string_view out_sep
+){
+	if(columns.empty())
+		throw std::invalid_argument("project_join: no columns selected");
+	const detail::byte_set sep(std::string_view(&in_sep, 1));
+	std::vector<std::string_view> fields;
+	detail::locate_fields(record, sep, *std::max_element(columns.begin(), columns.end())+1, fields);
+	const size_t size=detail::projection_size(fields, columns, out_sep);
+	std::string result;
+#if defined(__cpp_lib_string_resize_and_overwrite)
+	result.resize_and_overwrite(
+		size,
+		[&](char *out, size_t n){
+			detail::write_projection(out, fields, columns, out_sep);
+			return n;
+		}
+	);
+#else
+	result.reserve(size);
+	detail::append_projection(result, fields, columns, out_sep);
+#endif
+	return result;
+}
+
+inline std::string project_join(
+	std::string_view record, char in_sep, const std::vector<size_t> &columns, char out_sep
+){
+	return project_join(record, in_sep, columns, std::string_view(&out_sep, 1));
+}
+
+
+/****** Exact sizes of split and join results. ******/
+// Number of fields split() would return, the characters in all of them
+// and the length of the longest one.
+struct split_sizes {
+	size_t fields=0;
+	size_t chars=0;
+	size_t longest=0;
+};
+
+namespace detail {
+
+template<class char_t>
+inline split_sizes split_size(
+	std::basic_string_view<char_t> str, std::basic_string_view<char_t> sep, size_t max_fields
+){
+	static_assert(
+		uses_split_core<char_t, std::char_traits<char_t>>,
+		"split_size() needs a standard character type"
+	);
+	field_tally t;
+	if(max_fields)
+		split_core(str.data(), str.size(), sep.data(), sep.size(), sizeof(char_t), max_fields, t.sink, &t);
+	else
+		t=tally_fields(str, sep, false);
+	split_sizes result;
+	result.fields=t.fields;
+	result.chars=t.chars;
+	result.longest=t.longest;
+	return result;
+}
+
+// Characters that inserting elem into a stream like basic_join()'s adds.
+template<class char_t, class char_traits_t, class elem_t>
+inline size_t inserted_length(
+	const elem_t &elem, std::basic_ostringstream<char_t, char_traits_t> &fallback
+){
+	if constexpr(is_string_like<elem_t>::value)
+		return elem.size();
+	else if constexpr(std::is_same_v<elem_t, char_t>)
+		return 1;
+	else if constexpr(std::is_same_v<std::decay_t<elem_t>, const char_t *> || std::is_same_v<std::decay_t<elem_t>, char_t *>)
+		return char_traits_t::length(elem);
+	else {
+		fallback.str(std::basic_string<char_t, char_traits_t>());
+		fallback << elem;
+		return static_cast<size_t>(fallback.tellp());
+	}
+}
+
+}	// namespace detail
+
+// Like split(str, sep, max_fields), but only counts.  With max_fields=0 and
+// a one-character char separator, this is a single vectorised count of
+// separators; field lengths are then not examined, and longest is zero.
+template<class char_t>
+inline split_sizes split_size(
+	std::basic_string_view<char_t> str, char_t sep, size_t max_fields=0
+){
+	return detail::split_size(str, std::basic_string_view<char_t>(&sep, 1), max_fields);
+}
+
+template<class char_t>
+inline split_sizes split_size(
+	std::basic_string_view<char_t> str, std::basic_string_view<char_t> sep, size_t max_fields=0
+){
+	return detail::split_size(str, sep, max_fields);
+}
+
+template<class char_t, class in_ch_alloc_t>
+inline split_sizes split_size(
+	const std::basic_string<char_t, std::char_traits<char_t>, in_ch_alloc_t> &str, char_t sep,
+	size_t max_fields=0
+){
+	return
+		detail::split_size(
+			std::basic_string_view<char_t>(str), std::basic_string_view<char_t>(&sep, 1),
+			max_fields
+		)
+	;
+}
+
+template<class char_t, class in_ch_alloc_t>
+inline split_sizes split_size(
+	const std::basic_string<char_t, std::char_traits<char_t>, in_ch_alloc_t> &str,
+	std::basic_string_view<char_t> sep, size_t max_fields=0
+){
+	return detail::split_size(std::basic_string_view<char_t>(str), sep, max_fields);
+}
+
+// Exact length of the string basic_join() would return for the same
+// arguments.  Strings and characters are measured directly; other
+// elements are formatted, one at a time, into a reused stream.
+template<
+	class char_t=char, class char_traits_t=std::char_traits<char_t>,
+	class input_iter_t,
+	class joiner_t, class last_joiner_t
+>
+inline size_t joined_size(
+	input_iter_t first, input_iter_t last,
+	const joiner_t &joiner, const last_joiner_t &last_joiner,
+	const std::locale &out_locale=std::locale()
+){
+	std::basic_ostringstream<char_t, char_traits_t> fallback;
+	fallback.imbue(out_locale);
+	size_t n=0, len=0;
+	for(; first!=last; ++first, ++n)
+		len+=detail::inserted_length(*first, fallback);
+	if(n>1)
+		len+=
+			(n-2)*detail::inserted_length(joiner, fallback)+
+			detail::inserted_length(last_joiner, fallback)
+		;
+	return len;
+}
+
+template<
+	class char_t=char, class char_traits_t=std::char_traits<char_t>,
+	class container_t,
+	class joiner_t, class last_joiner_t
+>
+inline size_t joined_size(
+	const container_t &cont,
+	const joiner_t &joiner, const last_joiner_t &last_joiner,
+	const std::locale &out_locale=std::locale()
+){
+	return
+		joined_size<char_t, char_traits_t>(
+			std::begin(cont), std::end(cont), joiner, last_joiner, out_locale
+		)
+	;
+}
+
+template<class char_t=char, class char_traits_t=std::char_traits<char_t>, class container_t, class joiner_t>
+inline size_t joined_size(
+	const container_t &cont, const joiner_t &joiner,
+	const std::locale &out_locale=std::locale()
+){
+	return
+		joined_size<char_t, char_traits_t>(
+			std::begin(cont), std::end(cont), joiner, joiner, out_locale
+		)
+	;
+}
+
+template<class container_t>
+inline size_t joined_size(const container_t &cont){
+	return joined_size<char>(std::begin(cont), std::end(cont), ' ', ' ');
+}
+
+
+/****** Explicit instantiations for the compiled-library mode. ******/
+#define ORG_PPIRES_SPLIT_INSTANTIATE_SPLIT(extern_kw, char_t) \
+	extern_kw template std::vector<std::basic_string<char_t>> \
+	split<char_t, std::char_traits<char_t>>( \
+		std::basic_string_view<char_t>, char_t, size_t, \
+		const std::allocator<char_t> &, const std::allocator<std::basic_string<char_t>> & \
+	); \
+	extern_kw template std::vector<std::basic_string<char_t>> \
+	split<char_t, std::char_traits<char_t>>( \
+		std::basic_string_view<char_t>, std::basic_string_view<char_t>, size_t, \
+		const std::allocator<char_t> &, const std::allocator<std::basic_string<char_t>> & \
+	);
+
+#define ORG_PPIRES_SPLIT_INSTANTIATE_JOIN_ITER(extern_kw, char_t, iter_t, joiner_t) \
+	extern_kw template std::basic_string<char_t> \
+	basic_join<char_t, std::char_traits<char_t>, std::allocator<char_t>, iter_t, joiner_t, joiner_t>( \
+		iter_t, iter_t, joiner_t const &, joiner_t const &, \
+		const std::locale &, const std::allocator<char_t> \
+	);
+
+#define ORG_PPIRES_SPLIT_INSTANTIATE_JOIN(extern_kw, char_t, joiner_t) \
+	ORG_PPIRES_SPLIT_INSTANTIATE_JOIN_ITER( \
+		extern_kw, char_t, std::vector<std::basic_string<char_t>>::iterator, joiner_t \
+	) \
+	ORG_PPIRES_SPLIT_INSTANTIATE_JOIN_ITER( \
+		extern_kw, char_t, std::vector<std::basic_string<char_t>>::const_iterator, joiner_t \
+	)
+
+// The standard library provides stream insertion only for char and
+// wchar_t, so those are the only types with join instantiations.
+#define ORG_PPIRES_SPLIT_INSTANTIATE_ALL(extern_kw) \
+	ORG_PPIRES_SPLIT_INSTANTIATE_SPLIT(extern_kw, char) \
+	ORG_PPIRES_SPLIT_INSTANTIATE_SPLIT(extern_kw, wchar_t) \
+	ORG_PPIRES_SPLIT_INSTANTIATE_SPLIT(extern_kw, char16_t) \
+	ORG_PPIRES_SPLIT_INSTANTIATE_SPLIT(extern_kw, char32_t) \
+	ORG_PPIRES_SPLIT_INSTANTIATE_JOIN(extern_kw, char, char) \
+	ORG_PPIRES_SPLIT_INSTANTIATE_JOIN(extern_kw, char, const char *) \
+	ORG_PPIRES_SPLIT_INSTANTIATE_JOIN(extern_kw, char, std::string_view) \
+	ORG_PPIRES_SPLIT_INSTANTIATE_JOIN(extern_kw, char, std::string) \
+	ORG_PPIRES_SPLIT_INSTANTIATE_JOIN(extern_kw, wchar_t, wchar_t) \
+	ORG_PPIRES_SPLIT_INSTANTIATE_JOIN(extern_kw, wchar_t, const wchar_t *) \
+	ORG_PPIRES_SPLIT_INSTANTIATE_JOIN(extern_kw, wchar_t, std::wstring_view) \
+	ORG_PPIRES_SPLIT_INSTANTIATE_JOIN(extern_kw, wchar_t, std::wstring)
+
+#if __cplusplus >= 202002L
+#define ORG_PPIRES_SPLIT_INSTANTIATE_CHAR8(extern_kw) \
+	ORG_PPIRES_SPLIT_INSTANTIATE_SPLIT(extern_kw, char8_t)
+#else
+#define ORG_PPIRES_SPLIT_INSTANTIATE_CHAR8(extern_kw)
+#endif
+
+#if defined(ORG_PPIRES_SPLIT_COMPILED) && !defined(ORG_PPIRES_SPLIT_IMPLEMENTATION)
+ORG_PPIRES_SPLIT_INSTANTIATE_ALL(extern)
+ORG_PPIRES_SPLIT_INSTANTIATE_CHAR8(extern)
+#endif
+
 }	// namespace org::ppires.
 
 
+// The regex-based overloads, including the whitespace split(str), live in
+// split_regex.h, so that translation units which only split on characters
+// and strings can skip <regex> by defining ORG_PPIRES_SPLIT_NO_REGEX.
+#if !defined(ORG_PPIRES_SPLIT_NO_REGEX)
+#include "split_regex.h"
+#endif
+
+
 #endif	// !defined(ORG_PPIRES_SPLIT_H__)
@@ -0,0 +1,208 @@
+/*
+	split_cache.h -- A sharded, memoising cache of split() results, kept
+	                 apart from split.h so that only the translation units
+	                 that use it compile the locking and container headers
+	                 it needs.
+
+	Author: Paulo A. P. Pires
+	Copyright 2018-2020, Paulo A. P. Pires
+
+	This file is temporarily licensed for general use.  Please submit
+	suggestions and improvements back to me, so I can ad them to the
+	repository.
+*/
+
+
+#ifndef ORG_PPIRES_SPLIT_CACHE_H__
+#define ORG_PPIRES_SPLIT_CACHE_H__
+
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "split.h"
+
+
+namespace org::ppires {
+
+/****** Memoising split cache. ******/
+// Opt-in cache for inputs that are split over and over again, such as
+// configuration strings, header values and routing keys.  Results are
+// shared, immutable vectors.  The cache is divided into shards, each with
+// its own lock and least-recently-used list, and each holding at most
+// 1/n_shards of the entry and byte budgets.  Bytes count the cached key
+// and the heap memory of the result, as reported by memory_usage().
+template<class char_t, class out_ch_alloc_t=std::allocator<char_t>>
+class basic_split_cache {
+	static_assert(
+		detail::uses_split_core<char_t, std::char_traits<char_t>>,
+		"basic_split_cache needs a standard character type"
+	);
+
+public:
+	using string_type=std::basic_string<char_t, std::char_traits<char_t>, out_ch_alloc_t>;
+	using view_type=std::basic_string_view<char_t>;
+	// The vector type split() returns for string_type elements.
+	using result_type=std::vector<string_type, std::allocator<string_type>>;
+	using result_ptr=std::shared_ptr<const result_type>;
+
+	struct statistics {
+		size_t hits, misses, evictions, entries, bytes;
+	};
+
+	explicit basic_split_cache(
+		size_t max_entries=4096, size_t max_bytes=16*1024*1024, size_t n_shards=16,
+		const out_ch_alloc_t &allocator=out_ch_alloc_t()
+	):
+		shards(std::max<size_t>(n_shards, 1)),
+		shard_entries(std::max<size_t>(max_entries/shards.size(), 1)),
+		shard_bytes(max_bytes/shards.size()),
+		alloc_ch(allocator)
+	{ }
+
+	result_ptr split(view_type str, char_t sep, size_t max_fields=0){
+		return lookup(str, view_type(&sep, 1), max_fields);
+	}
+
+	result_ptr split(view_type str, view_type sep, size_t max_fields=0){
+		return lookup(str, sep, max_fields);
+	}
+
+	statistics stats() const {
+		statistics s{hits.load(), misses.load(), evictions.load(), 0, 0};
+		for(auto &sh: shards){
+			std::lock_guard<std::mutex> lock(sh.mutex);
+			s.entries+=sh.lru.size();
+			s.bytes+=sh.bytes;
+		}
+		return s;
+	}
+
+	void clear(){
+		for(auto &sh: shards){
+			std::lock_guard<std::mutex> lock(sh.mutex);
+			sh.index.clear();
+			sh.lru.clear();
+			sh.bytes=0;
+		}
+	}
+
+private:
+	struct key_type {
+		std::basic_string<char_t> str, sep;
+		size_t max_fields;
+
+		bool operator==(const key_type &other) const {
+			return max_fields==other.max_fields && str==other.str && sep==other.sep;
+		}
+	};
+
+	struct key_ref {
+		view_type str, sep;
+		size_t max_fields;
+		size_t hash;
+	};
+
+	struct entry {
+		key_type key;
+		size_t hash;
+		size_t bytes;
+		result_ptr result;
+	};
+
+	struct shard {
+		mutable std::mutex mutex;
+		std::list<entry> lru;	// Most recently used first.
+		std::unordered_multimap<size_t, typename std::list<entry>::iterator> index;
+		size_t bytes=0;
+	};
+
+	static size_t hash_of(view_type str, view_type sep, size_t max_fields){
+		std::hash<view_type> h;
+		size_t seed=h(str);
+		seed^=h(sep)+0x9e3779b97f4a7c15ull+(seed<<6)+(seed>>2);
+		seed^=max_fields+0x9e3779b97f4a7c15ull+(seed<<6)+(seed>>2);
+		return seed;
+	}
+
+	// Finds an entry in sh, whose lock is held, and marks it most recent.
+	static result_ptr find(shard &sh, const key_ref &k){
+		auto [first, last]=sh.index.equal_range(k.hash);
+		for(; first!=last; ++first){
+			auto it=first->second;
+			if(it->key.max_fields==k.max_fields && it->key.str==k.str && it->key.sep==k.sep){
+				sh.lru.splice(sh.lru.begin(), sh.lru, it);
+				return it->result;
+			}
+		}
+		return nullptr;
+	}
+
+	void evict_one(shard &sh){
+		auto victim=std::prev(sh.lru.end());
+		auto [first, last]=sh.index.equal_range(victim->hash);
+		for(; first!=last; ++first)
+			if(first->second==victim){
+				sh.index.erase(first);
+				break;
+			}
+		sh.bytes-=victim->bytes;
+		sh.lru.erase(victim);
+		++evictions;
+	}
+
+	result_ptr lookup(view_type str, view_type sep, size_t max_fields){
+		const key_ref k{str, sep, max_fields, hash_of(str, sep, max_fields)};
+		shard &sh=shards[k.hash%shards.size()];
+		{
+			std::lock_guard<std::mutex> lock(sh.mutex);
+			if(auto found=find(sh, k)){
+				++hits;
+				return found;
+			}
+		}
+		++misses;
+
+		// Split without holding the lock; if another thread stored the same
+		// key meanwhile, its result is kept.
+		auto result=std::make_shared<const result_type>(org::ppires::split(str, sep, max_fields, alloc_ch));
+		const size_t bytes=
+			(str.size()+sep.size())*sizeof(char_t)+memory_usage(*result).heap_bytes()
+		;
+		if(bytes>shard_bytes)
+			return result;
+		std::lock_guard<std::mutex> lock(sh.mutex);
+		if(auto found=find(sh, k))
+			return found;
+		while(!sh.lru.empty() && (sh.lru.size()>=shard_entries || sh.bytes+bytes>shard_bytes))
+			evict_one(sh);
+		sh.lru.push_front(
+			entry{key_type{std::basic_string<char_t>(str), std::basic_string<char_t>(sep), max_fields}, k.hash, bytes, result}
+		);
+		sh.index.emplace(k.hash, sh.lru.begin());
+		sh.bytes+=bytes;
+		return result;
+	}
+
+	std::vector<shard> shards;
+	const size_t shard_entries, shard_bytes;
+	const out_ch_alloc_t alloc_ch;
+	std::atomic<size_t> hits{0}, misses{0}, evictions{0};
+};
+
+using split_cache=basic_split_cache<char>;
+using wsplit_cache=basic_split_cache<wchar_t>;
+
+}	// namespace org::ppires.
+
+
+#endif	// !defined(ORG_PPIRES_SPLIT_CACHE_H__)
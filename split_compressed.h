@@ -0,0 +1,461 @@
+/*
+	split_compressed.h -- Splitting of gzip/zlib or zstd compressed input
+	                      while it is being decompressed, kept apart from
+	                      split.h because it needs zlib and/or libzstd at
+	                      link time.
+
+	Author: Paulo A. P. Pires
+	Copyright 2018-2020, Paulo A. P. Pires
+
+	This file is temporarily licensed for general use.  Please submit
+	suggestions and improvements back to me, so I can ad them to the
+	repository.
+*/
+
+
+#ifndef ORG_PPIRES_SPLIT_COMPRESSED_H__
+#define ORG_PPIRES_SPLIT_COMPRESSED_H__
+
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <istream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "split.h"
+
+// Define ORG_PPIRES_SPLIT_NO_ZLIB or ORG_PPIRES_SPLIT_NO_ZSTD to leave a
+// library out even though its header is installed.
+#if defined(__has_include)
+#if !defined(ORG_PPIRES_SPLIT_NO_ZLIB) && __has_include(<zlib.h>)
+#include <zlib.h>
+#define ORG_PPIRES_SPLIT_HAVE_ZLIB
+#endif
+#if !defined(ORG_PPIRES_SPLIT_NO_ZSTD) && __has_include(<zstd.h>)
+#include <zstd.h>
+#define ORG_PPIRES_SPLIT_HAVE_ZSTD
+#endif
+#endif
+
+
+#if defined(ORG_PPIRES_SPLIT_HAVE_ZLIB) || defined(ORG_PPIRES_SPLIT_HAVE_ZSTD)
+namespace org::ppires {
+
+/****** Splitting of compressed input. ******/
+enum class compression {
+	detect,	// zstd if the input starts with its magic number, else gzip/zlib.
+	gzip,	// gzip or zlib, including concatenated gzip members.
+	zstd
+};
+
+// One thread decompresses into n_blocks buffers of block_size bytes while
+// the calling thread splits the filled ones, so memory stays at about
+// n_blocks*block_size, plus the longest record that spans two blocks.
+struct decompress_options {
+	compression format=compression::detect;
+	size_t block_size=256*1024;
+	size_t n_blocks=4;
+	size_t input_size=64*1024;
+};
+
+struct decompress_split_stats {
+	size_t compressed_bytes=0;
+	size_t decompressed_bytes=0;
+	size_t records=0;
+};
+
+namespace detail {
+
+using read_fn=size_t (*)(void *src, char *buf, size_t len);
+
+// Hands decompressed blocks from the producer thread to the consumer.
+class block_queue {
+public:
+	block_queue(size_t n_blocks, size_t size): block_size(size){
+		for(size_t i=0; i<n_blocks; ++i){
+			storage.emplace_back(new char[block_size]);
+			free_blocks.push_back(storage.back().get());
+		}
+	}
+
+	size_t capacity() const { return block_size; }
+
+	// Producer side; acquire() returns nullptr once the consumer gave up.
+	char *acquire(){
+		std::unique_lock<std::mutex> lock(mutex);
+		cv.wait(lock, [this]{ return cancelled || !free_blocks.empty(); });
+		if(cancelled)
+			return nullptr;
+		char *block=free_blocks.front();
+		free_blocks.pop_front();
+		return block;
+	}
+
+	void push(char *block, size_t len){
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			filled.emplace_back(block, len);
+		}
+		cv.notify_all();
+	}
+
+	void close(std::exception_ptr err=nullptr){
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			closed=true;
+			error=err;
+		}
+		cv.notify_all();
+	}
+
+	// Consumer side; pop() returns false at the end of the input, or
+	// rethrows the producer's exception.
+	bool pop(std::pair<char *, size_t> &block){
+		std::unique_lock<std::mutex> lock(mutex);
+		cv.wait(lock, [this]{ return closed || !filled.empty(); });
+		if(!filled.empty()){
+			block=filled.front();
+			filled.pop_front();
+			return true;
+		}
+		if(error)
+			std::rethrow_exception(error);
+		return false;
+	}
+
+	void release(char *block){
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			free_blocks.push_back(block);
+		}
+		cv.notify_all();
+	}
+
+	void cancel(){
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			cancelled=true;
+		}
+		cv.notify_all();
+	}
+
+private:
+	size_t block_size;
+	std::vector<std::unique_ptr<char[]>> storage;
+	std::deque<char *> free_blocks;
+	std::deque<std::pair<char *, size_t>> filled;
+	bool closed=false, cancelled=false;
+	std::exception_ptr error;
+	std::mutex mutex;
+	std::condition_variable cv;
+};
+
+// Output side of a decompressor: the free part of the current block.
+class block_writer {
+public:
+	explicit block_writer(block_queue &queue): q(queue){ }
+
+	// False if the consumer gave up.
+	bool room(char *&out, size_t &len){
+		if(!block && !(block=q.acquire()))
+			return false;
+		out=block+used;
+		len=q.capacity()-used;
+		return true;
+	}
+
+	void advance(size_t n){
+		used+=n;
+		if(used==q.capacity())
+			flush();
+	}
+
+	void flush(){
+		if(block && used){
+			q.push(block, used);
+			block=nullptr;
+			used=0;
+		}
+	}
+
+private:
+	block_queue &q;
+	char *block=nullptr;
+	size_t used=0;
+};
+
+struct compressed_source {
+	read_fn read;
+	void *src;
+	std::unique_ptr<char[]> buf;
+	size_t buf_size, pos=0, len=0, total=0;
+
+	// False at the end of the input.
+	bool fill(){
+		pos=0;
+		len=read(src, buf.get(), buf_size);
+		total+=len;
+		return len;
+	}
+};
+
+#if defined(ORG_PPIRES_SPLIT_HAVE_ZLIB)
+inline void inflate_blocks(compressed_source &in, block_writer &out){
+	z_stream z{};
+	// 32 added to the window bits accepts both gzip and zlib headers.
+	if(inflateInit2(&z, 15+32)!=Z_OK)
+		throw std::runtime_error("split_compressed: inflateInit2 failed");
+	std::unique_ptr<z_stream, int (*)(z_stream *)> guard(&z, inflateEnd);
+	// More input is read only once inflate() has flushed all it can.
+	bool in_member=false, drained=true;
+	for(;;){
+		if(in.pos==in.len && drained && !in.fill())
+			break;
+		if(!in_member){
+			if(inflateReset(&z)!=Z_OK)
+				throw std::runtime_error("split_compressed: inflateReset failed");
+			in_member=true;
+		}
+		char *dest;
+		size_t room;
+		if(!out.room(dest, room))
+			return;
+		z.next_in=reinterpret_cast<Bytef *>(in.buf.get()+in.pos);
+		z.avail_in=static_cast<uInt>(in.len-in.pos);
+		z.next_out=reinterpret_cast<Bytef *>(dest);
+		z.avail_out=static_cast<uInt>(std::min<size_t>(room, std::numeric_limits<uInt>::max()));
+		const uInt avail_out=z.avail_out;
+		const int rc=inflate(&z, Z_NO_FLUSH);
+		in.pos=in.len-z.avail_in;
+		out.advance(avail_out-z.avail_out);
+		drained=z.avail_out!=0;
+		if(rc==Z_STREAM_END){
+			in_member=false;
+			drained=true;
+		}
+		else if(rc!=Z_OK && rc!=Z_BUF_ERROR)
+			throw std::runtime_error(
+				std::string("split_compressed: ")+(z.msg? z.msg: "corrupt gzip/zlib data")
+			);
+	}
+	if(in_member)
+		throw std::runtime_error("split_compressed: truncated gzip/zlib data");
+}
+#endif
+
+#if defined(ORG_PPIRES_SPLIT_HAVE_ZSTD)
+inline void zstd_decompress_blocks(compressed_source &in, block_writer &out){
+	std::unique_ptr<ZSTD_DStream, size_t (*)(ZSTD_DStream *)> ds(ZSTD_createDStream(), ZSTD_freeDStream);
+	if(!ds)
+		throw std::bad_alloc();
+	// A return of zero means the last frame ended.
+	size_t hint=0;
+	bool drained=true;
+	for(;;){
+		if(in.pos==in.len && drained && !in.fill())
+			break;
+		char *dest;
+		size_t room;
+		if(!out.room(dest, room))
+			return;
+		ZSTD_inBuffer zin{in.buf.get(), in.len, in.pos};
+		ZSTD_outBuffer zout{dest, room, 0};
+		hint=ZSTD_decompressStream(ds.get(), &zout, &zin);
+		if(ZSTD_isError(hint))
+			throw std::runtime_error(std::string("split_compressed: ")+ZSTD_getErrorName(hint));
+		in.pos=zin.pos;
+		out.advance(zout.pos);
+		drained=zout.pos<zout.size || !hint;
+	}
+	if(hint)
+		throw std::runtime_error("split_compressed: truncated zstd data");
+}
+#endif
+
+inline void decompress_blocks(compressed_source &in, block_writer &out, compression format){
+	if(format==compression::detect){
+		// Zstandard frames start with 28 B5 2F FD.
+		static const unsigned char zstd_magic[4]={0x28, 0xB5, 0x2F, 0xFD};
+		while(in.len<sizeof zstd_magic){
+			const size_t n=in.read(in.src, in.buf.get()+in.len, sizeof zstd_magic-in.len);
+			if(!n)
+				break;
+			in.len+=n;
+			in.total+=n;
+		}
+		format=
+			in.len==sizeof zstd_magic && std::memcmp(in.buf.get(), zstd_magic, sizeof zstd_magic)==0?
+			compression::zstd: compression::gzip
+		;
+	}
+	switch(format){
+#if defined(ORG_PPIRES_SPLIT_HAVE_ZLIB)
+		case compression::gzip:
+			inflate_blocks(in, out);
+			break;
+#endif
+#if defined(ORG_PPIRES_SPLIT_HAVE_ZSTD)
+		case compression::zstd:
+			zstd_decompress_blocks(in, out);
+			break;
+#endif
+		default:
+			throw std::invalid_argument("split_compressed: compression format not built in");
+	}
+	out.flush();
+}
+
+template<class record_fn_t>
+struct compressed_record_splitter {
+	char record_sep, field_sep;
+	record_fn_t &on_record;
+	std::vector<std::string_view> fields;
+	std::string carry;	// Start of a record that continues in the next block.
+	const char *record=nullptr;
+	size_t records=0;
+
+	compressed_record_splitter(char rec_sep, char fld_sep, record_fn_t &record_fn):
+		record_sep(rec_sep), field_sep(fld_sep), on_record(record_fn)
+	{ }
+
+	static void sink(void *ctx, size_t pos, size_t len){
+		auto &self=*static_cast<compressed_record_splitter *>(ctx);
+		self.fields.emplace_back(self.record+pos, len);
+	}
+
+	void emit(std::string_view rec){
+		fields.clear();
+		record=rec.data();
+		split_core(rec.data(), rec.size(), &field_sep, 1, 1, 0, sink, this);
+		++records;
+		on_record(static_cast<const std::vector<std::string_view> &>(fields));
+	}
+
+	void block(std::string_view data){
+		if(!carry.empty()){
+			const size_t end=data.find(record_sep);
+			if(end==std::string_view::npos){
+				carry.append(data);
+				return;
+			}
+			carry.append(data.substr(0, end));
+			emit(carry);
+			carry.clear();
+			data.remove_prefix(end+1);
+		}
+		size_t end;
+		while((end=data.find(record_sep))!=std::string_view::npos){
+			emit(data.substr(0, end));
+			data.remove_prefix(end+1);
+		}
+		carry.assign(data);
+	}
+
+	void finish(){
+		if(!carry.empty())
+			emit(carry);
+	}
+};
+
+template<class record_fn_t>
+inline decompress_split_stats split_compressed(
+	read_fn read, void *src, char record_sep, char field_sep,
+	record_fn_t &on_record, const decompress_options &opts
+){
+	if(!opts.block_size || !opts.n_blocks || !opts.input_size)
+		throw std::invalid_argument("split_compressed: sizes must not be zero");
+	compressed_source in{read, src, std::unique_ptr<char[]>(new char[opts.input_size]), opts.input_size};
+	block_queue q(opts.n_blocks, opts.block_size);
+	std::thread producer(
+		[&]{
+			try {
+				block_writer out(q);
+				decompress_blocks(in, out, opts.format);
+				q.close();
+			}
+			catch(...){
+				q.close(std::current_exception());
+			}
+		}
+	);
+
+	decompress_split_stats stats;
+	compressed_record_splitter<record_fn_t> splitter(record_sep, field_sep, on_record);
+	try {
+		std::pair<char *, size_t> block;
+		while(q.pop(block)){
+			stats.decompressed_bytes+=block.second;
+			splitter.block(std::string_view(block.first, block.second));
+			q.release(block.first);
+		}
+		splitter.finish();
+	}
+	catch(...){
+		q.cancel();
+		producer.join();
+		throw;
+	}
+	producer.join();
+	stats.compressed_bytes=in.total;
+	stats.records=splitter.records;
+	return stats;
+}
+
+}	// namespace detail
+
+// Decompresses in and calls on_record(const std::vector<std::string_view> &)
+// with the fields of each record, as split(record, field_sep) would produce
+// them.  Every record_sep ends a record, and a non-empty tail is the last
+// one.  The views are only valid during the call.  Errors in the compressed
+// data throw std::runtime_error, and an exception thrown by on_record stops
+// the decompression thread and propagates.
+template<class record_fn_t>
+inline decompress_split_stats split_compressed(
+	std::istream &in, char record_sep, char field_sep,
+	record_fn_t &&on_record, const decompress_options &opts=decompress_options()
+){
+	return detail::split_compressed(
+		[](void *src, char *buf, size_t len)->size_t {
+			auto &is=*static_cast<std::istream *>(src);
+			is.read(buf, static_cast<std::streamsize>(len));
+			if(is.bad())
+				throw std::runtime_error("split_compressed: read error");
+			return static_cast<size_t>(is.gcount());
+		},
+		&in, record_sep, field_sep, on_record, opts
+	);
+}
+
+template<class record_fn_t>
+inline decompress_split_stats split_compressed(
+	FILE *fp, char record_sep, char field_sep,
+	record_fn_t &&on_record, const decompress_options &opts=decompress_options()
+){
+	return detail::split_compressed(
+		[](void *src, char *buf, size_t len)->size_t {
+			auto *file=static_cast<FILE *>(src);
+			const size_t n=std::fread(buf, 1, len, file);
+			if(n<len && std::ferror(file))
+				throw std::runtime_error("split_compressed: read error");
+			return n;
+		},
+		fp, record_sep, field_sep, on_record, opts
+	);
+}
+
+}	// namespace org::ppires.
+#endif
+
+
+#endif	// !defined(ORG_PPIRES_SPLIT_COMPRESSED_H__)
@@ -0,0 +1,98 @@
+/*
+	split_format.h -- std::format() support for joined ranges, kept apart
+	                  from split.h so that only the translation units that
+	                  use it compile <format>.  Needs C++20 and a standard
+	                  library that provides std::format.
+
+	Author: Paulo A. P. Pires
+	Copyright 2018-2020, Paulo A. P. Pires
+
+	This file is temporarily licensed for general use.  Please submit
+	suggestions and improvements back to me, so I can ad them to the
+	repository.
+*/
+
+
+#ifndef ORG_PPIRES_SPLIT_FORMAT_H__
+#define ORG_PPIRES_SPLIT_FORMAT_H__
+
+
+#include "split.h"
+
+#if defined(__cpp_lib_format)
+#include <algorithm>
+#include <format>
+#include <iterator>
+#include <string_view>
+#include <type_traits>
+
+
+namespace org::ppires {
+
+/****** std::format support for joined ranges. ******/
+// A range to be formatted with its elements separated by joiner, and the
+// last two by last_joiner.  It refers to the range and separators, which
+// must outlive it; it is meant to be a std::format() argument, where the
+// format spec (e.g. "{:.2f}") applies to every element, and elements are
+// written straight to the output without a temporary string.
+template<class range_t, class char_t>
+struct joined_range {
+	const range_t &range;
+	std::basic_string_view<char_t> joiner;
+	std::basic_string_view<char_t> last_joiner;
+};
+
+template<class char_t=char, class range_t>
+inline joined_range<range_t, char_t> joined(
+	const range_t &range,
+	std::type_identity_t<std::basic_string_view<char_t>> joiner,
+	std::type_identity_t<std::basic_string_view<char_t>> last_joiner
+){
+	return {range, joiner, last_joiner};
+}
+
+template<class char_t=char, class range_t>
+inline joined_range<range_t, char_t> joined(
+	const range_t &range,
+	std::type_identity_t<std::basic_string_view<char_t>> joiner
+){
+	return {range, joiner, joiner};
+}
+
+}	// namespace org::ppires.
+
+
+template<class range_t, class char_t>
+struct std::formatter<org::ppires::joined_range<range_t, char_t>, char_t> {
+	using elem_t=std::remove_cvref_t<decltype(*std::begin(std::declval<const range_t &>()))>;
+
+	std::formatter<elem_t, char_t> elem_formatter;
+
+	constexpr auto parse(std::basic_format_parse_context<char_t> &ctx){
+		return elem_formatter.parse(ctx);
+	}
+
+	template<class format_context_t>
+	auto format(const org::ppires::joined_range<range_t, char_t> &j, format_context_t &ctx) const {
+		auto out=ctx.out();
+		auto first=std::begin(j.range);
+		const auto last=std::end(j.range);
+		if(first!=last){
+			auto next=first;
+			for(++next; ; ++next){
+				ctx.advance_to(out);
+				out=elem_formatter.format(*first, ctx);
+				if(next==last)
+					break;
+				first=next;
+				auto sep=(std::next(next)==last? j.last_joiner: j.joiner);
+				out=std::copy(sep.begin(), sep.end(), out);
+			}
+		}
+		return out;
+	}
+};
+#endif
+
+
+#endif	// !defined(ORG_PPIRES_SPLIT_FORMAT_H__)
@@ -0,0 +1,585 @@
+/*
+	split_parallel.h -- Operations on whole buffers of delimited records
+	                    (partitioning, profiling, field-count validation
+	                    and column projection) that can run on several
+	                    threads; kept apart from split.h so that only the
+	                    translation units that use them compile <thread>.
+
+	Author: Paulo A. P. Pires
+	Copyright 2018-2020, Paulo A. P. Pires
+
+	This file is temporarily licensed for general use.  Please submit
+	suggestions and improvements back to me, so I can ad them to the
+	repository.
+*/
+
+
+#ifndef ORG_PPIRES_SPLIT_PARALLEL_H__
+#define ORG_PPIRES_SPLIT_PARALLEL_H__
+
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "split.h"
+
+
+namespace org::ppires {
+
+/****** Partitioning of records by a key field. ******/
+namespace detail {
+
+// Cuts buffer, just after record separators, into at most n pieces of
+// about the same size.
+inline std::vector<std::string_view> record_chunks(std::string_view buffer, char record_sep, size_t n){
+	std::vector<std::string_view> chunks;
+	size_t a=0;
+	for(size_t i=1; i<n && a<buffer.size(); ++i){
+		size_t b=std::max(a, buffer.size()/n*i);
+		b=buffer.find(record_sep, b);
+		if(b==std::string_view::npos)
+			break;
+		chunks.push_back(buffer.substr(a, b+1-a));
+		a=b+1;
+	}
+	if(a<buffer.size() || chunks.empty())
+		chunks.push_back(buffer.substr(a));
+	return chunks;
+}
+
+// Threads to use for size bytes: n_threads, or one per core if zero, but
+// never so many that a thread gets less than min_bytes.
+inline size_t thread_count(size_t n_threads, size_t size, size_t min_bytes=1024*1024){
+	if(!n_threads)
+		n_threads=std::max(std::thread::hardware_concurrency(), 1u);
+	return std::max<size_t>(std::min(n_threads, size/min_bytes), 1);
+}
+
+// Calls fn(i) for every i below n, each on its own thread (i==0 on the
+// calling one), and rethrows the first exception after all have finished.
+template<class fn_t>
+inline void parallel_for(size_t n, fn_t &&fn){
+	std::vector<std::exception_ptr> errors(n);
+	auto run=[&](size_t i){
+		try {
+			fn(i);
+		}
+		catch(...){
+			errors[i]=std::current_exception();
+		}
+	};
+	std::vector<std::thread> threads;
+	threads.reserve(n? n-1: 0);
+	for(size_t i=1; i<n; ++i)
+		threads.emplace_back(run, i);
+	if(n)
+		run(0);
+	for(auto &t: threads)
+		t.join();
+	for(auto &e: errors)
+		if(e)
+			std::rethrow_exception(e);
+}
+
+// Calls out(bucket, record) for every record of buffer, without copying it.
+template<class out_t>
+inline void scatter_records(
+	std::string_view buffer, char record_sep, char field_sep,
+	size_t key_field, size_t n_buckets, out_t &&out
+){
+	const char seps[]={record_sep, field_sep};
+	const byte_set delims(std::string_view(seps, 2));
+	const char *p=buffer.data(), *const last=p+buffer.size();
+	while(p!=last){
+		const char *key=p, *end=delims.find(p, last);
+		size_t f=0;
+		for(; f<key_field && end!=last && *end==field_sep; ++f){
+			key=end+1;
+			end=delims.find(key, last);
+		}
+		// Records without the key field hash as an empty key.
+		uint64_t h=fnv1a_basis;
+		if(f==key_field)
+			for(const char *k=key; k!=end; ++k)
+				h=(h^static_cast<unsigned char>(*k))*fnv1a_prime;
+		if(end!=last && *end!=record_sep){
+			auto r=static_cast<const char *>(std::memchr(end, record_sep, last-end));
+			end=r? r: last;
+		}
+		out(static_cast<size_t>(h%n_buckets), std::string_view(p, end-p));
+		p=(end==last? last: end+1);
+	}
+}
+
+}	// namespace detail
+
+// Distributes the records of buffer (separated by record_sep, a trailing
+// one optional) among n_buckets by a hash of field key_field (counted from
+// zero, fields separated by field_sep).  Records are views into buffer,
+// without their separators, in their original order within each bucket.
+// Records without the key field go where an empty key goes.  With
+// n_threads other than 1 (0 meaning one per core), each thread partitions
+// one part of buffer into its own buckets, which are appended in order at
+// the end.
+inline std::vector<std::vector<std::string_view>> partition_records(
+	std::string_view buffer, char record_sep, char field_sep,
+	size_t key_field, size_t n_buckets, size_t n_threads=1
+){
+	if(!n_buckets)
+		throw std::invalid_argument("partition_records: n_buckets must not be zero");
+	const auto chunks=detail::record_chunks(
+		buffer, record_sep, detail::thread_count(n_threads, buffer.size())
+	);
+	std::vector<std::vector<std::vector<std::string_view>>> parts(
+		chunks.size(), std::vector<std::vector<std::string_view>>(n_buckets)
+	);
+	detail::parallel_for(
+		chunks.size(),
+		[&](size_t i){
+			auto &buckets=parts[i];
+			detail::scatter_records(
+				chunks[i], record_sep, field_sep, key_field, n_buckets,
+				[&](size_t b, std::string_view rec){ buckets[b].push_back(rec); }
+			);
+		}
+	);
+	auto result=std::move(parts[0]);
+	for(size_t b=0; b<n_buckets; ++b)
+		for(size_t i=1; i<parts.size(); ++i)
+			result[b].insert(result[b].end(), parts[i][b].begin(), parts[i][b].end());
+	return result;
+}
+
+// Like partition_records(), but copies the records into one buffer per
+// bucket, each record followed by record_sep.
+inline std::vector<std::string> partition_records_copy(
+	std::string_view buffer, char record_sep, char field_sep,
+	size_t key_field, size_t n_buckets, size_t n_threads=1
+){
+	if(!n_buckets)
+		throw std::invalid_argument("partition_records_copy: n_buckets must not be zero");
+	const auto chunks=detail::record_chunks(
+		buffer, record_sep, detail::thread_count(n_threads, buffer.size())
+	);
+	std::vector<std::vector<std::string>> parts(chunks.size(), std::vector<std::string>(n_buckets));
+	detail::parallel_for(
+		chunks.size(),
+		[&](size_t i){
+			auto &buckets=parts[i];
+			for(auto &b: buckets)
+				b.reserve(chunks[i].size()/n_buckets+chunks[i].size()/(4*n_buckets));
+			detail::scatter_records(
+				chunks[i], record_sep, field_sep, key_field, n_buckets,
+				[&](size_t b, std::string_view rec){
+					buckets[b].append(rec);
+					buckets[b].push_back(record_sep);
+				}
+			);
+		}
+	);
+	auto result=std::move(parts[0]);
+	for(size_t b=0; b<n_buckets; ++b){
+		size_t total=result[b].size();
+		for(size_t i=1; i<parts.size(); ++i)
+			total+=parts[i][b].size();
+		result[b].reserve(total);
+		for(size_t i=1; i<parts.size(); ++i)
+			result[b].append(parts[i][b]);
+	}
+	return result;
+}
+
+
+/****** Profiling of delimited buffers. ******/
+// Approximate count of distinct values, from 64-bit hashes of them, with
+// 2^precision one-byte registers (a relative error of about
+// 1.04/sqrt(2^precision)).
+class hyperloglog {
+public:
+	explicit hyperloglog(unsigned precision=12):
+		p(std::clamp(precision, 4u, 18u)), registers(size_t(1)<<p)
+	{ }
+
+	void add_hash(uint64_t h){
+		const uint64_t rest=h<<p;
+		const uint8_t rank=rest? uint8_t(detail::clz64(rest)+1): uint8_t(64-p+1);
+		uint8_t &r=registers[h>>(64-p)];
+		r=std::max(r, rank);
+	}
+
+	// Sketches must have the same precision.
+	void merge(const hyperloglog &other){
+		if(other.p!=p)
+			throw std::invalid_argument("hyperloglog::merge: precisions differ");
+		for(size_t i=0; i<registers.size(); ++i)
+			registers[i]=std::max(registers[i], other.registers[i]);
+	}
+
+	double estimate() const {
+		const double m=double(registers.size());
+		double sum=0;
+		size_t zeros=0;
+		for(uint8_t r: registers){
+			sum+=std::ldexp(1.0, -int(r));
+			zeros+=!r;
+		}
+		// Bias correction constants from Flajolet et al.; the formula only
+		// holds from 128 registers on.
+		const double alpha=
+			registers.size()==16? 0.673: registers.size()==32? 0.697:
+			registers.size()==64? 0.709: 0.7213/(1+1.079/m)
+		;
+		const double e=alpha*m*m/sum;
+		// Linear counting is more accurate while many registers are empty.
+		if(e<=2.5*m && zeros)
+			return m*std::log(m/double(zeros));
+		return e;
+	}
+
+	unsigned precision() const { return p; }
+
+private:
+	unsigned p;
+	std::vector<uint8_t> registers;
+};
+
+// Bucket 0 counts empty fields; bucket k, lengths from 2^(k-1) to 2^k-1.
+constexpr size_t n_length_buckets=65;
+
+struct column_profile {
+	size_t fields=0, empty=0;
+	size_t total_length=0, min_length=split_max, max_length=0;
+	size_t length_histogram[n_length_buckets]{};
+	hyperloglog distinct;
+
+	explicit column_profile(unsigned hll_precision=12): distinct(hll_precision){ }
+
+	double mean_length() const { return fields? double(total_length)/fields: 0; }
+
+	void merge(const column_profile &other){
+		fields+=other.fields;
+		empty+=other.empty;
+		total_length+=other.total_length;
+		min_length=std::min(min_length, other.min_length);
+		max_length=std::max(max_length, other.max_length);
+		for(size_t i=0; i<n_length_buckets; ++i)
+			length_histogram[i]+=other.length_histogram[i];
+		distinct.merge(other.distinct);
+	}
+};
+
+// Result of profile_fields().  fields_per_record[n] counts the records
+// that have n fields.
+struct buffer_profile {
+	size_t bytes=0, records=0, fields=0;
+	size_t field_separators=0, record_separators=0;
+	std::vector<size_t> fields_per_record;
+	std::vector<column_profile> columns;
+
+	// Separators per byte of input.
+	double separator_density() const {
+		return bytes? double(field_separators+record_separators)/bytes: 0;
+	}
+
+	void merge(const buffer_profile &other){
+		bytes+=other.bytes;
+		records+=other.records;
+		fields+=other.fields;
+		field_separators+=other.field_separators;
+		record_separators+=other.record_separators;
+		if(fields_per_record.size()<other.fields_per_record.size())
+			fields_per_record.resize(other.fields_per_record.size());
+		for(size_t i=0; i<other.fields_per_record.size(); ++i)
+			fields_per_record[i]+=other.fields_per_record[i];
+		const unsigned precision=
+			columns.empty()? other.columns.empty()? 12: other.columns[0].distinct.precision():
+			columns[0].distinct.precision()
+		;
+		if(columns.size()<other.columns.size())
+			columns.resize(other.columns.size(), column_profile(precision));
+		for(size_t i=0; i<other.columns.size(); ++i)
+			columns[i].merge(other.columns[i]);
+	}
+};
+
+namespace detail {
+
+// Final mixing step of SplitMix64, which spreads FNV-1a's weak high bits.
+inline uint64_t mix64(uint64_t h){
+	h=(h^(h>>30))*0xbf58476d1ce4e5b9ull;
+	h=(h^(h>>27))*0x94d049bb133111ebull;
+	return h^(h>>31);
+}
+
+inline void profile_part(
+	buffer_profile &prof, std::string_view buffer, char record_sep, char field_sep,
+	unsigned hll_precision
+){
+	const char seps[]={record_sep, field_sep};
+	const byte_set delims(std::string_view(seps, 2));
+	const char *p=buffer.data(), *const last=p+buffer.size();
+	prof.bytes=buffer.size();
+	size_t column=0;
+	auto add_field=[&](const char *a, const char *b){
+		if(column>=prof.columns.size())
+			prof.columns.resize(column+1, column_profile(hll_precision));
+		auto &col=prof.columns[column];
+		const size_t len=b-a;
+		uint64_t h=fnv1a_basis;
+		for(; a!=b; ++a)
+			h=(h^static_cast<unsigned char>(*a))*fnv1a_prime;
+		col.distinct.add_hash(mix64(h));
+		++col.fields;
+		col.empty+=!len;
+		col.total_length+=len;
+		col.min_length=std::min(col.min_length, len);
+		col.max_length=std::max(col.max_length, len);
+		++col.length_histogram[len? 64-clz64(len): 0];
+		++column;
+	};
+	auto end_record=[&]{
+		if(column>=prof.fields_per_record.size())
+			prof.fields_per_record.resize(column+1);
+		++prof.fields_per_record[column];
+		++prof.records;
+		prof.fields+=column;
+		column=0;
+	};
+	while(p!=last){
+		const char *end=delims.find(p, last);
+		add_field(p, end);
+		if(end==last)
+			p=last;
+		else {
+			p=end+1;
+			if(*end==field_sep){
+				++prof.field_separators;
+				// A field separator at the very end leaves an empty last field.
+				if(p==last)
+					add_field(p, p);
+			}
+			else {
+				++prof.record_separators;
+				end_record();
+			}
+		}
+	}
+	if(column)
+		end_record();
+}
+
+}	// namespace detail
+
+// Gathers, in one scan and without copying any field, the statistics of
+// buffer, which holds records separated by record_sep (a trailing one is
+// optional) with fields separated by field_sep: field counts per record,
+// separator density, and, per column, field lengths and an approximate
+// count of distinct values.  With n_threads other than 1 (0 meaning one
+// per core), parts of buffer are profiled in parallel and then merged.
+inline buffer_profile profile_fields(
+	std::string_view buffer, char record_sep, char field_sep,
+	size_t n_threads=1, unsigned hll_precision=12
+){
+	const auto chunks=detail::record_chunks(
+		buffer, record_sep, detail::thread_count(n_threads, buffer.size())
+	);
+	std::vector<buffer_profile> parts(chunks.size());
+	detail::parallel_for(
+		chunks.size(),
+		[&](size_t i){
+			detail::profile_part(parts[i], chunks[i], record_sep, field_sep, hll_precision);
+		}
+	);
+	for(size_t i=1; i<parts.size(); ++i)
+		parts[0].merge(parts[i]);
+	return std::move(parts[0]);
+}
+
+
+/****** Validation of field counts. ******/
+// A record of validate_field_counts() with the wrong number of fields:
+// its index, counted from zero, the offset of its first byte, and the
+// number of fields it has.
+struct field_count_violation {
+	size_t record, offset, fields;
+};
+
+struct field_count_report {
+	size_t records=0, n_violations=0;
+	std::vector<field_count_violation> violations;	// The first ones only.
+};
+
+namespace detail {
+
+// Checks part, which starts at byte base_offset of the whole buffer.
+// Record indices are local to part.
+inline field_count_report check_field_counts(
+	std::string_view part, size_t base_offset, char record_sep, char field_sep,
+	size_t expected, size_t max_violations
+){
+	field_count_report report;
+	const char *p=part.data(), *const last=p+part.size(), *rec_start=p;
+	size_t seps=0;
+	auto end_record=[&](const char *next){
+		if(seps+1!=expected){
+			++report.n_violations;
+			if(report.violations.size()<max_violations)
+				report.violations.push_back({report.records, base_offset+(rec_start-part.data()), seps+1});
+		}
+		++report.records;
+		seps=0;
+		rec_start=next;
+	};
+#if defined(__SSE2__)
+	// Separators are counted sixteen bytes at a time, as the popcount of
+	// the field separator mask, split at the bits of record separators.
+	const byte_set recs(std::string_view(&record_sep, 1)), flds(std::string_view(&field_sep, 1));
+	for(; last-p>=16; p+=16){
+		unsigned rm=recs.match_mask(p), fm=flds.match_mask(p);
+		while(rm){
+			const unsigned bit=__builtin_ctz(rm);
+			const unsigned upto=(2u<<bit)-1;
+			seps+=__builtin_popcount(fm&upto);
+			fm&=~upto;
+			end_record(p+bit+1);
+			rm&=rm-1;
+		}
+		seps+=__builtin_popcount(fm);
+	}
+#endif
+	for(; p!=last; ++p){
+		if(*p==record_sep)
+			end_record(p+1);
+		else
+			seps+=(*p==field_sep);
+	}
+	if(rec_start!=last)
+		end_record(last);
+	return report;
+}
+
+}	// namespace detail
+
+// Checks that every record of buffer (separated by record_sep, a trailing
+// one optional) has expected fields (separated by field_sep), counting
+// separators without splitting anything.  The report has the total number
+// of records and of violations, and the first max_violations of these.
+// With n_threads other than 1 (0 meaning one per core), parts of buffer are
+// checked in parallel.
+inline field_count_report validate_field_counts(
+	std::string_view buffer, char record_sep, char field_sep, size_t expected,
+	size_t max_violations=split_max, size_t n_threads=1
+){
+	if(record_sep==field_sep)
+		throw std::invalid_argument("validate_field_counts: record_sep and field_sep must differ");
+	const auto chunks=detail::record_chunks(
+		buffer, record_sep, detail::thread_count(n_threads, buffer.size())
+	);
+	std::vector<field_count_report> parts(chunks.size());
+	detail::parallel_for(
+		chunks.size(),
+		[&](size_t i){
+			parts[i]=detail::check_field_counts(
+				chunks[i], chunks[i].data()-buffer.data(), record_sep, field_sep,
+				expected, max_violations
+			);
+		}
+	);
+	field_count_report report=std::move(parts[0]);
+	for(size_t i=1; i<parts.size(); ++i){
+		for(auto &v: parts[i].violations){
+			if(report.violations.size()>=max_violations)
+				break;
+			v.record+=report.records;
+			report.violations.push_back(v);
+		}
+		report.records+=parts[i].records;
+		report.n_violations+=parts[i].n_violations;
+	}
+	return report;
+}
+
+
+/****** Projection of whole buffers. ******/
+namespace detail {
+
+inline std::string project_records(
+	std::string_view buffer, char record_sep, char in_sep,
+	const std::vector<size_t> &columns, std::string_view out_sep
+){
+	const byte_set sep(std::string_view(&in_sep, 1));
+	const size_t n_fields=*std::max_element(columns.begin(), columns.end())+1;
+	std::vector<std::string_view> fields;
+	// Projections are usually smaller than their input; if not, append()
+	// grows the output geometrically.
+	std::string result;
+	result.reserve(buffer.size());
+	const char *p=buffer.data(), *const last=p+buffer.size();
+	while(p!=last){
+		auto end=static_cast<const char *>(std::memchr(p, record_sep, last-p));
+		if(!end)
+			end=last;
+		locate_fields(std::string_view(p, end-p), sep, n_fields, fields);
+		append_projection(result, fields, columns, out_sep);
+		result.push_back(record_sep);
+		p=(end==last? last: end+1);
+	}
+	return result;
+}
+
+}	// namespace detail
+
+// project_join() of every record of buffer, separated by record_sep (a
+// trailing one is optional); each output record ends with record_sep.  An
+// empty columns throws std::invalid_argument, as in project_join().
+// With n_threads other than 1 (0 meaning one per core), parts of buffer are
+// projected in parallel and then concatenated.
+inline std::string project_join_records(
+	std::string_view buffer, char record_sep, char in_sep,
+	const std::vector<size_t> &columns, std::string_view out_sep, size_t n_threads=1
+){
+	if(columns.empty())
+		throw std::invalid_argument("project_join_records: no columns selected");
+	const auto chunks=detail::record_chunks(
+		buffer, record_sep, detail::thread_count(n_threads, buffer.size())
+	);
+	std::vector<std::string> parts(chunks.size());
+	detail::parallel_for(
+		chunks.size(),
+		[&](size_t i){
+			parts[i]=detail::project_records(chunks[i], record_sep, in_sep, columns, out_sep);
+		}
+	);
+	if(parts.size()==1)
+		return std::move(parts[0]);
+	size_t total=0;
+	for(auto &part: parts)
+		total+=part.size();
+	std::string result;
+	result.reserve(total);
+	for(auto &part: parts)
+		result.append(part);
+	return result;
+}
+
+inline std::string project_join_records(
+	std::string_view buffer, char record_sep, char in_sep,
+	const std::vector<size_t> &columns, char out_sep, size_t n_threads=1
+){
+	return project_join_records(
+		buffer, record_sep, in_sep, columns, std::string_view(&out_sep, 1), n_threads
+	);
+}
+
+}	// namespace org::ppires.
+
+
+#endif	// !defined(ORG_PPIRES_SPLIT_PARALLEL_H__)
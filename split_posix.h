@@ -0,0 +1,386 @@
+/*
+	split_posix.h -- Extensions of split.h that need POSIX (and, for shared
+	                 memory, Linux) system calls, kept apart from split.h
+	                 so that portable translation units never see the
+	                 system headers.
+
+	Author: Paulo A. P. Pires
+	Copyright 2018-2020, Paulo A. P. Pires
+
+	This file is temporarily licensed for general use.  Please submit
+	suggestions and improvements back to me, so I can ad them to the
+	repository.
+*/
+
+
+#ifndef ORG_PPIRES_SPLIT_POSIX_H__
+#define ORG_PPIRES_SPLIT_POSIX_H__
+
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+#include "split.h"
+
+#if defined(__has_include)
+#if __has_include(<unistd.h>)
+#include <unistd.h>
+#define ORG_PPIRES_SPLIT_HAVE_UNISTD
+#endif
+#if defined(__linux__) && __has_include(<sys/mman.h>) && __has_include(<memory_resource>)
+#include <memory_resource>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#if defined(MFD_CLOEXEC)
+#define ORG_PPIRES_SPLIT_HAVE_MEMFD
+#endif
+#endif
+#endif
+
+
+namespace org::ppires {
+
+#if defined(ORG_PPIRES_SPLIT_HAVE_UNISTD)
+/****** Incremental join to file descriptors. ******/
+// A basic_join_writer that writes to a file descriptor with write(2),
+// resuming after short writes and EINTR.  The descriptor is not closed.
+template<class char_t, class char_traits_t=std::char_traits<char_t>, class out_ch_alloc_t=std::allocator<char_t>>
+class basic_fd_join_writer: public basic_join_writer<char_t, char_traits_t, out_ch_alloc_t> {
+	using base_type=basic_join_writer<char_t, char_traits_t, out_ch_alloc_t>;
+
+public:
+	using typename base_type::view_type;
+
+	basic_fd_join_writer(
+		view_type joiner_text, view_type last_joiner_text,
+		int fd, size_t threshold=64*1024
+	):
+		base_type(
+			joiner_text, last_joiner_text,
+			write_fd, reinterpret_cast<void *>(static_cast<intptr_t>(fd)), threshold
+		)
+	{ }
+
+private:
+	static void write_fd(void *d, const char_t *data, size_t n){
+		const int fd=static_cast<int>(reinterpret_cast<intptr_t>(d));
+		auto p=reinterpret_cast<const char *>(data);
+		size_t left=n*sizeof(char_t);
+		while(left){
+			ssize_t w=::write(fd, p, left);
+			if(w<0){
+				if(errno==EINTR)
+					continue;
+				throw std::system_error(errno, std::generic_category(), "join_writer: write");
+			}
+			p+=w;
+			left-=w;
+		}
+	}
+};
+
+using fd_join_writer=basic_fd_join_writer<char>;
+using wfd_join_writer=basic_fd_join_writer<wchar_t>;
+#endif
+
+
+#if defined(ORG_PPIRES_SPLIT_HAVE_MEMFD)
+/****** Split results in shared memory. ******/
+// A memory resource over a memfd_create() segment, and split results laid
+// out in it with offsets relative to the segment base instead of pointers.
+// A process that receives the descriptor (over a UNIX socket, or through
+// /proc/<pid>/fd) can attach() it, map it at any address and read the
+// fields in place, without copying or parsing anything.
+class shared_arena: public std::pmr::memory_resource {
+public:
+	// Creates and maps a segment of capacity bytes; name is only shown in
+	// /proc/<pid>/fd and is not required to be unique.
+	explicit shared_arena(size_t capacity, const char *name="org.ppires.split"){
+		capacity=std::max(capacity, sizeof(segment_header));
+		fd_=memfd_create(name, MFD_CLOEXEC);
+		if(fd_<0)
+			throw std::system_error(errno, std::generic_category(), "memfd_create");
+		if(ftruncate(fd_, static_cast<off_t>(capacity))!=0){
+			const int err=errno;
+			::close(fd_);
+			throw std::system_error(err, std::generic_category(), "ftruncate");
+		}
+		map(capacity, PROT_READ|PROT_WRITE);
+		header()->magic=segment_magic;
+		header()->used=sizeof(segment_header);
+	}
+
+	// Maps, read-only, a segment created by another shared_arena, taking
+	// ownership of fd.
+	static shared_arena attach(int fd){
+		return shared_arena(attach_tag{}, fd);
+	}
+
+	shared_arena(const shared_arena &)=delete;
+	shared_arena &operator=(const shared_arena &)=delete;
+
+	~shared_arena() override {
+		if(base_!=MAP_FAILED)
+			munmap(base_, capacity_);
+		if(fd_>=0)
+			::close(fd_);
+	}
+
+	int fd() const { return fd_; }
+	const std::byte *base() const { return static_cast<const std::byte *>(base_); }
+	size_t capacity() const { return capacity_; }
+	size_t used() const { return header()->used; }
+	bool writable() const { return writable_; }
+
+private:
+	struct segment_header {
+		uint64_t magic;
+		uint64_t used;
+	};
+
+	static constexpr uint64_t segment_magic=0x317261702e707370ull;
+
+	struct attach_tag { };
+
+	shared_arena(attach_tag, int fd): fd_(fd){
+		struct stat st;
+		if(fstat(fd_, &st)!=0){
+			const int err=errno;
+			::close(fd_);
+			throw std::system_error(err, std::generic_category(), "fstat");
+		}
+		writable_=false;
+		map(static_cast<size_t>(st.st_size), PROT_READ);
+		if(capacity_<sizeof(segment_header) || header()->magic!=segment_magic){
+			munmap(base_, capacity_);
+			::close(fd_);
+			throw std::invalid_argument("shared_arena: not a split segment");
+		}
+	}
+
+	void map(size_t capacity, int prot){
+		capacity_=capacity;
+		base_=mmap(nullptr, capacity_, prot, MAP_SHARED, fd_, 0);
+		if(base_==MAP_FAILED){
+			const int err=errno;
+			::close(fd_);
+			fd_=-1;
+			throw std::system_error(err, std::generic_category(), "mmap");
+		}
+	}
+
+	segment_header *header() const { return static_cast<segment_header *>(base_); }
+
+	// Allocation only bumps the used mark; nothing is given back before the
+	// segment is unmapped.
+	void *do_allocate(size_t bytes, size_t alignment) override {
+		if(!writable_)
+			throw std::bad_alloc();
+		const size_t start=(header()->used+alignment-1)/alignment*alignment;
+		if(start>capacity_ || bytes>capacity_-start)
+			throw std::bad_alloc();
+		header()->used=start+bytes;
+		return static_cast<std::byte *>(base_)+start;
+	}
+
+	void do_deallocate(void *, size_t, size_t) override { }
+
+	bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+		return this==&other;
+	}
+
+	int fd_=-1;
+	void *base_=MAP_FAILED;
+	size_t capacity_=0;
+	bool writable_=true;
+};
+
+namespace detail {
+
+// Layout of a split result in a shared segment: this header, then a table
+// of n_fields {offset, length} pairs, then the characters.  Offsets are in
+// bytes from the segment base; lengths are in characters.
+struct shared_split_header {
+	uint64_t magic;
+	uint64_t n_fields;
+	uint64_t char_size;
+};
+
+struct shared_field {
+	uint64_t offset;
+	uint64_t length;
+};
+
+constexpr uint64_t shared_split_magic=0x746c757365722e73ull;
+
+template<class char_t>
+struct shared_field_writer {
+	shared_field *table;
+	char_t *chars;
+	const char_t *str;
+	const std::byte *base;
+
+	static void sink(void *ctx, size_t pos, size_t len){
+		auto &self=*static_cast<shared_field_writer *>(ctx);
+		self.table->offset=reinterpret_cast<const std::byte *>(self.chars)-self.base;
+		self.table->length=len;
+		++self.table;
+		std::char_traits<char_t>::copy(self.chars, self.str+pos, len);
+		self.chars+=len;
+	}
+};
+
+}	// namespace detail
+
+// Splits str into arena, as split() would, and returns the offset of the
+// result, which another process passes to shared_split_view.
+template<class char_t>
+inline size_t split_shared(
+	shared_arena &arena,
+	std::basic_string_view<char_t> str, std::basic_string_view<char_t> sep, size_t max_fields=0
+){
+	static_assert(
+		detail::uses_split_core<char_t, std::char_traits<char_t>>,
+		"split_shared() needs a standard character type"
+	);
+	detail::field_tally sizes;
+	if(max_fields)
+		detail::split_core(str.data(), str.size(), sep.data(), sep.size(), sizeof(char_t), max_fields, sizes.sink, &sizes);
+	else
+		sizes=detail::tally_fields(str, sep, false);
+	const size_t bytes=
+		sizeof(detail::shared_split_header)+sizes.fields*sizeof(detail::shared_field)+
+		sizes.chars*sizeof(char_t)
+	;
+	auto *header=static_cast<detail::shared_split_header *>(
+		arena.allocate(bytes, alignof(detail::shared_split_header))
+	);
+	auto *table=reinterpret_cast<detail::shared_field *>(header+1);
+	detail::shared_field_writer<char_t> out{
+		table, reinterpret_cast<char_t *>(table+sizes.fields), str.data(), arena.base()
+	};
+	detail::split_core(str.data(), str.size(), sep.data(), sep.size(), sizeof(char_t), max_fields, out.sink, &out);
+	header->n_fields=sizes.fields;
+	header->char_size=sizeof(char_t);
+	header->magic=detail::shared_split_magic;
+	return reinterpret_cast<const std::byte *>(header)-arena.base();
+}
+
+template<class char_t>
+inline size_t split_shared(
+	shared_arena &arena, std::basic_string_view<char_t> str, char_t sep, size_t max_fields=0
+){
+	return split_shared(arena, str, std::basic_string_view<char_t>(&sep, 1), max_fields);
+}
+
+inline size_t split_shared(
+	shared_arena &arena, std::string_view str, std::string_view sep, size_t max_fields=0
+){
+	return split_shared<char>(arena, str, sep, max_fields);
+}
+
+inline size_t split_shared(shared_arena &arena, std::string_view str, char sep, size_t max_fields=0){
+	return split_shared<char>(arena, str, sep, max_fields);
+}
+
+// Read-only view of a result written by split_shared(), in whichever
+// mapping of the segment base points to.  Offsets are checked against the
+// mapping size, so a corrupt segment throws instead of reading outside it.
+template<class char_t=char>
+class shared_split_view {
+public:
+	using view_type=std::basic_string_view<char_t>;
+
+	class iterator {
+	public:
+		using iterator_category=std::random_access_iterator_tag;
+		using value_type=view_type;
+		using difference_type=std::ptrdiff_t;
+		using pointer=void;
+		using reference=view_type;
+
+		iterator()=default;
+
+		view_type operator*() const { return (*owner)[idx]; }
+		iterator &operator++(){ ++idx; return *this; }
+		iterator operator++(int){ auto old=*this; ++idx; return old; }
+		iterator &operator--(){ --idx; return *this; }
+		iterator operator--(int){ auto old=*this; --idx; return old; }
+		iterator &operator+=(difference_type n){ idx+=n; return *this; }
+		iterator &operator-=(difference_type n){ idx-=n; return *this; }
+		iterator operator+(difference_type n) const { return iterator(owner, idx+n); }
+		iterator operator-(difference_type n) const { return iterator(owner, idx-n); }
+		difference_type operator-(const iterator &other) const {
+			return static_cast<difference_type>(idx)-static_cast<difference_type>(other.idx);
+		}
+		view_type operator[](difference_type n) const { return (*owner)[idx+n]; }
+		bool operator==(const iterator &other) const { return idx==other.idx; }
+		bool operator!=(const iterator &other) const { return idx!=other.idx; }
+		bool operator<(const iterator &other) const { return idx<other.idx; }
+
+	private:
+		friend class shared_split_view;
+		iterator(const shared_split_view *view, size_t i): owner(view), idx(i){ }
+
+		const shared_split_view *owner=nullptr;
+		size_t idx=0;
+	};
+
+	shared_split_view(const void *segment, size_t size, size_t offset):
+		base(static_cast<const std::byte *>(segment))
+	{
+		using detail::shared_split_header;
+		if(offset>size || size-offset<sizeof(shared_split_header) || offset%alignof(shared_split_header))
+			throw std::out_of_range("shared_split_view: offset outside the segment");
+		auto *header=reinterpret_cast<const shared_split_header *>(this->base+offset);
+		if(header->magic!=detail::shared_split_magic || header->char_size!=sizeof(char_t))
+			throw std::invalid_argument("shared_split_view: no split result of this character type at offset");
+		const size_t table_room=(size-offset-sizeof(shared_split_header))/sizeof(detail::shared_field);
+		if(header->n_fields>table_room)
+			throw std::out_of_range("shared_split_view: field table outside the segment");
+		n_fields=header->n_fields;
+		table=reinterpret_cast<const detail::shared_field *>(header+1);
+		for(size_t i=0; i<n_fields; ++i){
+			const auto &f=table[i];
+			if(
+				f.offset>size || f.offset%alignof(char_t) ||
+				f.length>(size-f.offset)/sizeof(char_t)
+			)
+				throw std::out_of_range("shared_split_view: field outside the segment");
+		}
+	}
+
+	shared_split_view(const shared_arena &arena, size_t offset):
+		shared_split_view(arena.base(), arena.capacity(), offset)
+	{ }
+
+	size_t size() const { return n_fields; }
+	bool empty() const { return !n_fields; }
+
+	view_type operator[](size_t i) const {
+		return view_type(reinterpret_cast<const char_t *>(base+table[i].offset), table[i].length);
+	}
+
+	iterator begin() const { return iterator(this, 0); }
+	iterator end() const { return iterator(this, n_fields); }
+
+private:
+	const std::byte *base;
+	const detail::shared_field *table=nullptr;
+	size_t n_fields=0;
+};
+#endif
+
+}	// namespace org::ppires.
+
+
+#endif	// !defined(ORG_PPIRES_SPLIT_POSIX_H__)
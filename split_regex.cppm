@@ -0,0 +1,30 @@
+/*
+	split_regex.cppm -- C++20 module interface for split_regex.h.
+
+	Author: Paulo A. P. Pires
+	Copyright 2018-2020, Paulo A. P. Pires
+
+	This file is temporarily licensed for general use.  Please submit
+	suggestions and improvements back to me, so I can ad them to the
+	repository.
+*/
+
+
+module;
+
+#include "split_regex.h"
+
+export module org.ppires.split.regex;
+
+export import org.ppires.split;
+
+
+export namespace org::ppires {
+
+using org::ppires::split;
+
+using org::ppires::basic_regex_chunk_splitter;
+using org::ppires::regex_chunk_splitter;
+using org::ppires::wregex_chunk_splitter;
+
+}	// namespace org::ppires.
@@ -0,0 +1,450 @@
+/*
+	split_regex.h -- Regular-expression based overloads of split(), kept
+	                 apart from split.h so that <regex> is only compiled by
+	                 the translation units that need it.
+
+	Author: Paulo A. P. Pires
+	Copyright 2018-2020, Paulo A. P. Pires
+
+	This file is temporarily licensed for general use.  Please submit
+	suggestions and improvements back to me, so I can ad them to the
+	repository.
+*/
+
+
+#ifndef ORG_PPIRES_SPLIT_REGEX_H__
+#define ORG_PPIRES_SPLIT_REGEX_H__
+
+
+#include <locale>
+#include <memory>
+#include <regex>
+
+#include "split.h"
+
+
+namespace org::ppires {
+
+/****** Split functions with arguments that are based on std::basic_string_view. ******/
+template<
+	class char_t, class char_traits_t,
+	class regex_traits_t,
+	class out_ch_alloc_t=std::allocator<char_t>,
+	class out_str_alloc_t=std::allocator<std::basic_string<char_t, char_traits_t, out_ch_alloc_t>>
+>
+ORG_PPIRES_SPLIT_INLINE std::vector<std::basic_string<char_t, char_traits_t, out_ch_alloc_t>, out_str_alloc_t>
+split(
+	const std::basic_string_view<char_t, char_traits_t> str,
+	const std::basic_regex<char_t, regex_traits_t> &sep_re,
+	size_t max_fields=0,
+	const out_ch_alloc_t &alloc_ch=out_ch_alloc_t(),
+	const out_str_alloc_t &alloc_str=out_str_alloc_t()
+){
+	std::vector<std::basic_string<char_t, char_traits_t, out_ch_alloc_t>, out_str_alloc_t> result;
+	const size_t str_len=str.length();
+	if(str_len){
+		std::match_results<decltype(str.begin())> sep;
+		auto a=str.cbegin();
+		if(max_fields--){
+			auto b=a;
+			do {
+				size_t sep_len=0;
+				if(
+					result.size()<max_fields &&
+					regex_search(a, str.end(), sep, sep_re)
+				){
+					sep_len=sep.length(0);
+					b=a+sep.position(0)+!sep_len;
+				}
+				else
+					b=str.cend();
+				result.emplace_back(a, b, alloc_ch);
+				a=b+sep_len;
+			} while(a!=str.cend());
+			if(b!=str.cend() && result.size()<max_fields)
+				result.emplace_back(alloc_ch);
+		}
+		else {
+			size_t trailing_empty=0;
+			do {
+				auto b=a;
+				size_t sep_len=0;
+				if(regex_search(a, str.end(), sep, sep_re)){
+					sep_len=sep.length(0);
+					b=a+sep.position(0)+!sep_len;
+				}
+				else
+					b=str.cend();
+				if(b==a)
+					++trailing_empty;
+				else {
+					for(; trailing_empty; --trailing_empty)
+						result.emplace_back();
+					result.emplace_back(a, b, alloc_ch);
+				}
+				a=b+sep_len;
+			} while(a!=str.cend());
+		}
+	}
+	return result;
+}
+
+#if 0	// Waiting for C++20's concepts
+template<
+	class char_t, class char_traits_t,
+	class out_ch_alloc_t=std::allocator<char_t>,
+	class out_str_alloc_t=std::allocator<std::basic_string<char_t, char_traits_t, out_ch_alloc_t>>
+>
+inline std::vector<std::basic_string<char_t, char_traits_t, out_ch_alloc_t>, out_str_alloc_t>
+split(
+	const std::basic_string_view<char_t, char_traits_t> str,
+	const out_ch_alloc_t &alloc_ch=out_ch_alloc_t(),
+	const out_str_alloc_t &alloc_str=out_str_alloc_t()
+){
+	static const char sep_re_8[]="\\s+";
+	static std::unique_ptr<std::basic_regex<char_t>> sep_re;
+	if(!sep_re){
+		auto &converter=std::use_facet<std::codecvt<char_t, char, std::mbstate_t>>(std::locale());
+		std::mbstate_t mbs{};
+		std::basic_string<char_t, char_traits_t> sep_str(sizeof sep_re_8, char_t());
+		const char *from_next;
+		char_t *to_next;
+		converter.in(
+			mbs,
+			sep_re_8, sep_re_8+sizeof sep_re_8, from_next,
+			&sep_str[0], &sep_str[sep_str.size()], to_next
+		);
+		sep_str.resize(to_next-&sep_str[0]);
+		sep_re.reset(new std::basic_regex<char_t>(sep_str));
+	}
+	return split(str, *sep_re, 0, alloc_ch, alloc_str);
+}
+
+template<
+	class char_traits_t,
+	class out_ch_alloc_t=std::allocator<char>,
+	class out_str_alloc_t=std::allocator<std::basic_string<char, char_traits_t, out_ch_alloc_t>>
+>
+inline std::vector<std::basic_string<char, char_traits_t, out_ch_alloc_t>, out_str_alloc_t>
+split(
+	const std::basic_string_view<char, char_traits_t> str,
+	const out_ch_alloc_t &alloc_ch=out_ch_alloc_t(),
+	const out_str_alloc_t &alloc_str=out_str_alloc_t()
+){
+	return split(str, std::regex("\\s+"), 0, alloc_ch, alloc_str);
+}
+
+template<
+	class char_traits_t,
+	class out_ch_alloc_t=std::allocator<wchar_t>,
+	class out_str_alloc_t=std::allocator<std::basic_string<wchar_t, char_traits_t, out_ch_alloc_t>>
+>
+inline std::vector<std::basic_string<wchar_t, char_traits_t, out_ch_alloc_t>, out_str_alloc_t>
+split(
+	const std::basic_string_view<wchar_t, char_traits_t> str,
+	const out_ch_alloc_t &alloc_ch=out_ch_alloc_t(),
+	const out_str_alloc_t &alloc_str=out_str_alloc_t()
+){
+	return split(str, std::wregex(L"\\s+"), 0, alloc_ch, alloc_str);
+}
+
+template<
+	class char_traits_t,
+	class out_ch_alloc_t=std::allocator<char32_t>,
+	class out_str_alloc_t=std::allocator<std::basic_string<char32_t, char_traits_t, out_ch_alloc_t>>
+>
+inline std::vector<std::basic_string<char32_t, char_traits_t, out_ch_alloc_t>, out_str_alloc_t>
+split(
+	const std::basic_string_view<char32_t, char_traits_t> str,
+	const out_ch_alloc_t &alloc_ch=out_ch_alloc_t(),
+	const out_str_alloc_t &alloc_str=out_str_alloc_t()
+){
+	return split(str, std::basic_regex<char32_t>(U"\\s+"), 0, alloc_ch, alloc_str);
+}
+
+template<
+	class char_traits_t,
+	class out_ch_alloc_t=std::allocator<char16_t>,
+	class out_str_alloc_t=std::allocator<std::basic_string<char16_t, char_traits_t, out_ch_alloc_t>>
+>
+inline std::vector<std::basic_string<char16_t, char_traits_t, out_ch_alloc_t>, out_str_alloc_t>
+split(
+	const std::basic_string_view<char16_t, char_traits_t> str,
+	const out_ch_alloc_t &alloc_ch=out_ch_alloc_t(),
+	const out_str_alloc_t &alloc_str=out_str_alloc_t()
+){
+	return split(str, std::basic_regex<char16_t>(u"\\s+"), 0, alloc_ch, alloc_str);
+}
+
+#if __cplusplus >= 202002L
+template<
+	class char_traits_t,
+	class out_ch_alloc_t=std::allocator<char8_t>,
+	class out_str_alloc_t=std::allocator<std::basic_string<char8_t, char_traits_t, out_ch_alloc_t>>
+>
+inline std::vector<std::basic_string<char8_t, char_traits_t, out_ch_alloc_t>, out_str_alloc_t>
+split(
+	const std::basic_string_view<char8_t, char_traits_t> str,
+	const out_ch_alloc_t &alloc_ch=out_ch_alloc_t(),
+	const out_str_alloc_t &alloc_str=out_str_alloc_t()
+){
+	return split(str, std::basic_regex<char8_t>(u8"\\s+"), 0, alloc_ch, alloc_str);
+}
+#endif
+#else
+template<class char_t, class char_traits_t>
+inline std::vector<std::basic_string<char_t, char_traits_t>>
+split(const std::basic_string_view<char_t, char_traits_t> str){
+	static const char sep_re_8[]="\\s+";
+	static std::unique_ptr<std::basic_regex<char_t>> sep_re;
+	if(!sep_re){
+		auto &converter=std::use_facet<std::codecvt<char_t, char, std::mbstate_t>>(std::locale());
+		std::mbstate_t mbs{};
+		std::basic_string<char_t, char_traits_t> sep_str(sizeof sep_re_8, char_t());
+		const char *from_next;
+		char_t *to_next;
+		converter.in(
+			mbs,
+			sep_re_8, sep_re_8+sizeof sep_re_8, from_next,
+			&sep_str[0], &sep_str[sep_str.size()], to_next
+		);
+		sep_str.resize(to_next-&sep_str[0]);
+		sep_re.reset(new std::basic_regex<char_t>(sep_str));
+	}
+	return split(str, *sep_re, 0);
+}
+
+template<class char_traits_t>
+inline std::vector<std::basic_string<char, char_traits_t>>
+split(const std::basic_string_view<char, char_traits_t> str){
+	return split(str, std::regex("\\s+"), 0);
+}
+
+template<class char_traits_t>
+inline std::vector<std::basic_string<wchar_t, char_traits_t>>
+split(const std::basic_string_view<wchar_t, char_traits_t> str){
+	return split(str, std::wregex(L"\\s+"), 0);
+}
+
+template<class char_traits_t>
+inline std::vector<std::basic_string<char32_t, char_traits_t>>
+split(const std::basic_string_view<char32_t, char_traits_t> str){
+	return split(str, std::basic_regex<char32_t>(U"\\s+"), 0);
+}
+
+template<class char_traits_t>
+inline std::vector<std::basic_string<char16_t, char_traits_t>>
+split(const std::basic_string_view<char16_t, char_traits_t> str){
+	return split(str, std::basic_regex<char16_t>(u"\\s+"), 0);
+}
+
+#if __cplusplus >= 202002L
+template<class char_traits_t>
+inline std::vector<std::basic_string<char8_t, char_traits_t>>
+split(	const std::basic_string_view<char8_t, char_traits_t> str){
+	return split(str, std::basic_regex<char8_t>(u8"\\s+"), 0);
+}
+#endif
+#endif
+
+
+/****** Split functions with at least one argument based on std::basic_string. ******/
+template<
+	class char_t, class char_traits_t,
+	class regex_traits_t,
+	class in_ch_alloc_t, class out_ch_alloc_t=in_ch_alloc_t,
+	class out_str_alloc_t=std::allocator<std::basic_string<char_t, char_traits_t, out_ch_alloc_t>>
+>
+inline std::vector<std::basic_string<char_t, char_traits_t, out_ch_alloc_t>, out_str_alloc_t>
+split(
+	const std::basic_string<char_t, char_traits_t, in_ch_alloc_t> &str,
+	const std::basic_regex<char_t, regex_traits_t> &sep_re,
+	size_t max_fields=0,
+	const out_ch_alloc_t &alloc_ch=out_ch_alloc_t(),
+	const out_str_alloc_t &alloc_str=out_str_alloc_t()
+){
+	return
+		split(
+			std::basic_string_view<char_t, char_traits_t>(str),
+			sep_re, max_fields,
+			alloc_ch, alloc_str
+		)
+	;
+}
+
+#if 0	// Waiting for C++-20 concepts.
+template<
+	class char_t, class char_traits_t,
+	class in_ch_alloc_t, class out_ch_alloc_t=in_ch_alloc_t,
+	class out_str_alloc_t=std::allocator<std::basic_string<char_t, char_traits_t, out_ch_alloc_t>>
+>
+inline std::vector<std::basic_string<char_t, char_traits_t, out_ch_alloc_t>, out_str_alloc_t>
+split(
+	const std::basic_string<char_t, char_traits_t, in_ch_alloc_t> &str,
+	const out_ch_alloc_t &alloc_ch=out_ch_alloc_t(),
+	const out_str_alloc_t &alloc_str=out_str_alloc_t()
+){
+	return
+		split(
+			std::basic_string_view<char_t, char_traits_t>(str),
+			alloc_ch, alloc_str
+		)
+	;
+}
+#else
+template<class char_t, class char_traits_t, class in_ch_alloc_t>
+inline std::vector<std::basic_string<char_t, char_traits_t>>
+split(const std::basic_string<char_t, char_traits_t, in_ch_alloc_t> &str){
+	return split(std::basic_string_view<char_t, char_traits_t>(str));
+}
+#endif
+
+
+/****** Split functions with argument(s) that is(are) pointer(s) to characters ******/
+template<
+	class char_t, class char_traits_t=std::char_traits<char_t>,
+	class regex_traits_t,
+	class out_ch_alloc_t=std::allocator<char_t>,
+	class out_str_alloc_t=std::allocator<std::basic_string<char_t, char_traits_t, out_ch_alloc_t>>
+>
+inline std::vector<std::basic_string<char_t, char_traits_t, out_ch_alloc_t>, out_str_alloc_t>
+split(
+	const char_t *str, const std::basic_regex<char_t, regex_traits_t> &sep_re,
+	size_t max_fields=0,
+	const char_traits_t trait_obj=char_traits_t(),
+	const out_ch_alloc_t &alloc_ch=out_ch_alloc_t(),
+	const out_str_alloc_t &alloc_str=out_str_alloc_t()
+){
+	return
+		split(
+			std::basic_string_view<char_t, char_traits_t>(str),
+			sep_re, max_fields,
+			alloc_ch, alloc_str
+		)
+	;
+}
+
+template<class char_t, class char_traits_t=std::char_traits<char_t>>
+inline std::vector<std::basic_string<char_t, char_traits_t>>
+split(const char_t *str){
+	return split(std::basic_string_view<char_t, char_traits_t>(str));
+}
+
+
+/****** Regex splitting of input that arrives in chunks. ******/
+// Splits a stream that is fed one chunk at a time, giving the same fields
+// as split(whole_input, separator) would.  Only the text after the last
+// separator known to be final is kept between chunks.
+//
+// A separator match is final when no text still to come can change it.
+// If match_limit, the longest text separator can match, is given, that is
+// once match_limit characters have arrived from where the match starts.  If
+// it is zero (unbounded), the unfinished tail is scanned again with every
+// chunk, and a match is taken as final once some text follows it; that is
+// exact for separators like "\\s+" or ",\\s*", but patterns whose leftmost
+// match may start earlier when more text arrives need match_limit.
+template<class char_t, class regex_traits_t=std::regex_traits<char_t>>
+class basic_regex_chunk_splitter {
+public:
+	using string_type=std::basic_string<char_t>;
+	using view_type=std::basic_string_view<char_t>;
+	using regex_type=std::basic_regex<char_t, regex_traits_t>;
+
+	explicit basic_regex_chunk_splitter(const regex_type &separator, size_t match_limit=0):
+		sep_re(separator), max_match(match_limit)
+	{ }
+
+	// Fields completed by chunk.
+	std::vector<string_type> feed(view_type chunk){
+		std::vector<string_type> result;
+		buf.append(chunk);
+		scan(false, result);
+		return result;
+	}
+
+	// Fields left at the end of the stream; the splitter can then be fed
+	// another one.
+	std::vector<string_type> finish(){
+		std::vector<string_type> result;
+		scan(true, result);
+		buf.clear();
+		trailing_empty=0;
+		return result;
+	}
+
+	// Characters held back, waiting for more input.
+	size_t pending() const { return buf.size(); }
+
+private:
+	void scan(bool last, std::vector<string_type> &result){
+		const char_t *const first=buf.data(), *const end=first+buf.size();
+		const char_t *a=first;
+		std::match_results<const char_t *> sep;
+		while(a!=end){
+			// Like split(), every search starts as if at the beginning of
+			// the input; only the end is not known to be the end yet.
+			auto flags=std::regex_constants::match_default;
+			if(!last)
+				flags|=std::regex_constants::match_not_eol|std::regex_constants::match_not_eow;
+			const bool found=std::regex_search(a, end, sep, sep_re, flags);
+			if(!last){
+				if(!found)
+					break;
+				const size_t start=(a-first)+sep.position(0);
+				if(
+					max_match?
+					buf.size()-start<max_match:
+					start+sep.length(0)==buf.size()
+				)
+					break;
+			}
+			const char_t *b=end;
+			size_t sep_len=0;
+			if(found){
+				sep_len=sep.length(0);
+				b=std::min(a+sep.position(0)+!sep_len, end);
+			}
+			if(b==a)
+				++trailing_empty;
+			else {
+				for(; trailing_empty; --trailing_empty)
+					result.emplace_back();
+				result.emplace_back(a, b);
+			}
+			a=std::min(b+sep_len, end);
+		}
+		buf.erase(0, a-first);
+	}
+
+	regex_type sep_re;
+	size_t max_match;
+	string_type buf;
+	size_t trailing_empty=0;
+};
+
+using regex_chunk_splitter=basic_regex_chunk_splitter<char>;
+using wregex_chunk_splitter=basic_regex_chunk_splitter<wchar_t>;
+
+
+/****** Explicit instantiations for the compiled-library mode. ******/
+#define ORG_PPIRES_SPLIT_INSTANTIATE_REGEX(extern_kw, char_t) \
+	extern_kw template std::vector<std::basic_string<char_t>> \
+	split<char_t, std::char_traits<char_t>, std::regex_traits<char_t>>( \
+		std::basic_string_view<char_t>, const std::basic_regex<char_t> &, size_t, \
+		const std::allocator<char_t> &, const std::allocator<std::basic_string<char_t>> & \
+	);
+
+// The standard library provides std::regex_traits only for char and
+// wchar_t.
+#define ORG_PPIRES_SPLIT_INSTANTIATE_REGEX_ALL(extern_kw) \
+	ORG_PPIRES_SPLIT_INSTANTIATE_REGEX(extern_kw, char) \
+	ORG_PPIRES_SPLIT_INSTANTIATE_REGEX(extern_kw, wchar_t)
+
+#if defined(ORG_PPIRES_SPLIT_COMPILED) && !defined(ORG_PPIRES_SPLIT_IMPLEMENTATION)
+ORG_PPIRES_SPLIT_INSTANTIATE_REGEX_ALL(extern)
+#endif
+
+}	// namespace org::ppires.
+
+
+#endif	// !defined(ORG_PPIRES_SPLIT_REGEX_H__)